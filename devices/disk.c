@@ -9,6 +9,7 @@
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -34,6 +35,7 @@
 #define STA_BSY 0x80  /* Busy. */
 #define STA_DRDY 0x40 /* Device Ready. */
 #define STA_DRQ 0x08  /* Data Request. */
+#define STA_ERR 0x01  /* Error. */
 
 /* Control Register bits. */
 #define CTL_SRST 0x04 /* Software Reset. */
@@ -49,6 +51,13 @@
 #define CMD_IDENTIFY_DEVICE 0xec    /* IDENTIFY DEVICE. */
 #define CMD_READ_SECTOR_RETRY 0x20  /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30 /* WRITE SECTOR with retries. */
+#define CMD_READ_MULTIPLE 0xc4      /* READ MULTIPLE. */
+#define CMD_WRITE_MULTIPLE 0xc5     /* WRITE MULTIPLE. */
+#define CMD_SET_MULTIPLE_MODE 0xc6  /* SET MULTIPLE MODE. */
+
+/* Most sectors transferred by one command.  The sector count
+   register is 8 bits wide, with 0 meaning 256. */
+#define MAX_SECTORS_PER_CMD 256
 
 /* An ATA device. */
 struct disk {
@@ -58,6 +67,8 @@ struct disk {
 
     bool is_ata;            /* 1=This device is an ATA disk. */
     disk_sector_t capacity; /* Capacity in sectors (if is_ata). */
+    int multiple_cnt;       /* Sectors per DRQ block for READ/WRITE
+                               MULTIPLE, or 0 if unsupported. */
 
     long long read_cnt;  /* Number of sectors read. */
     long long write_cnt; /* Number of sectors written. */
@@ -75,6 +86,10 @@ struct channel {
                                                                      any interrupt would be spurious. */
     struct semaphore completion_wait; /* Up'd by interrupt handler. */
 
+    struct list queue;        /* Pending disk_requests, by sector. */
+    struct semaphore pending; /* Number of requests in QUEUE. */
+    disk_sector_t head_pos;   /* Sector after the last one transferred. */
+
     struct disk devices[2]; /* The devices on this channel. */
 };
 
@@ -87,6 +102,8 @@ static bool check_device_type(struct disk *);
 static void identify_ata_device(struct disk *);
 
 static void select_sector(struct disk *, disk_sector_t);
+static void select_sectors(struct disk *, disk_sector_t, size_t cnt);
+static void set_multiple_mode(struct disk *, int cnt);
 static void issue_pio_command(struct channel *, uint8_t command);
 static void input_sector(struct channel *, void *);
 static void output_sector(struct channel *, const void *);
@@ -98,6 +115,9 @@ static void select_device_wait(const struct disk *);
 
 static void interrupt_handler(struct intr_frame *);
 
+static bool request_less(const struct list_elem *, const struct list_elem *, void *aux);
+static void disk_dispatcher(void *channel_);
+
 /* Initialize the disk subsystem and detect disks. */
 void disk_init(void) {
     size_t chan_no;
@@ -121,8 +141,12 @@ void disk_init(void) {
                 NOT_REACHED();
         }
         lock_init(&c->lock);
+        lock_register(&c->lock, c->name);
         c->expecting_interrupt = false;
         sema_init(&c->completion_wait, 0);
+        list_init(&c->queue);
+        sema_init(&c->pending, 0);
+        c->head_pos = 0;
 
         /* Initialize devices. */
         for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -133,6 +157,7 @@ void disk_init(void) {
 
             d->is_ata = false;
             d->capacity = 0;
+            d->multiple_cnt = 0;
 
             d->read_cnt = d->write_cnt = 0;
         }
@@ -151,6 +176,10 @@ void disk_init(void) {
         for (dev_no = 0; dev_no < 2; dev_no++)
             if (c->devices[dev_no].is_ata)
                 identify_ata_device(&c->devices[dev_no]);
+
+        /* Start the request dispatcher. */
+        if (thread_create(c->name, PRI_MAX, disk_dispatcher, c) == TID_ERROR)
+            PANIC("%s: dispatcher creation failed", c->name);
     }
 
     /* DO NOT MODIFY BELOW LINES. */
@@ -200,26 +229,25 @@ disk_sector_t disk_size(struct disk *d) {
     return d->capacity;
 }
 
+/* Returns the number of sectors per data block for a transfer on
+   D, and sets *CMD to the READ_CMD or WRITE_CMD variant to use.
+   Falls back to the single-sector commands, which also accept a
+   count but raise an interrupt per sector. */
+static size_t transfer_block(const struct disk *d, bool write, uint8_t *cmd) {
+    if (d->multiple_cnt > 0) {
+        *cmd = write ? CMD_WRITE_MULTIPLE : CMD_READ_MULTIPLE;
+        return d->multiple_cnt;
+    }
+    *cmd = write ? CMD_WRITE_SECTOR_RETRY : CMD_READ_SECTOR_RETRY;
+    return 1;
+}
+
 /* Reads sector SEC_NO from disk D into BUFFER, which must have
    room for DISK_SECTOR_SIZE bytes.
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 void disk_read(struct disk *d, disk_sector_t sec_no, void *buffer) {
-    struct channel *c;
-
-    ASSERT(d != NULL);
-    ASSERT(buffer != NULL);
-
-    c = d->channel;
-    lock_acquire(&c->lock);
-    select_sector(d, sec_no);
-    issue_pio_command(c, CMD_READ_SECTOR_RETRY);
-    sema_down(&c->completion_wait);
-    if (!wait_while_busy(d))
-        PANIC("%s: disk read failed, sector=%" PRDSNu, d->name, sec_no);
-    input_sector(c, buffer);
-    d->read_cnt++;
-    lock_release(&c->lock);
+    disk_read_multiple(d, sec_no, buffer, 1);
 }
 
 /* Write sector SEC_NO to disk D from BUFFER, which must contain
@@ -228,21 +256,207 @@ void disk_read(struct disk *d, disk_sector_t sec_no, void *buffer) {
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 void disk_write(struct disk *d, disk_sector_t sec_no, const void *buffer) {
+    disk_write_multiple(d, sec_no, buffer, 1);
+}
+
+/* Submits a request for CNT sectors at SEC_NO on D and waits for
+   it to complete. */
+static void disk_transfer_sync(struct disk *d, disk_sector_t sec_no, void *buffer, size_t cnt,
+                               bool write) {
+    struct disk_request req;
+
+    req.disk = d;
+    req.sector = sec_no;
+    req.cnt = cnt;
+    req.buffer = buffer;
+    req.write = write;
+    req.complete = NULL;
+    disk_submit(&req);
+    sema_down(&req.done);
+}
+
+/* Reads CNT consecutive sectors starting at SEC_NO from disk D
+   into BUFFER, which must have room for CNT * DISK_SECTOR_SIZE
+   bytes.  Issues one command per MAX_SECTORS_PER_CMD sectors and
+   takes one interrupt per READ MULTIPLE block rather than one per
+   sector.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void disk_read_multiple(struct disk *d, disk_sector_t sec_no, void *buffer, size_t cnt) {
+    disk_transfer_sync(d, sec_no, buffer, cnt, false);
+}
+
+/* Writes CNT consecutive sectors starting at SEC_NO to disk D
+   from BUFFER, which must contain CNT * DISK_SECTOR_SIZE bytes.
+   Returns after the disk has acknowledged receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void disk_write_multiple(struct disk *d, disk_sector_t sec_no, const void *buffer,
+                         size_t cnt) {
+    disk_transfer_sync(d, sec_no, (void *)buffer, cnt, true);
+}
+
+/* Queues REQ on its disk's channel and returns immediately.  When
+   the transfer is done, REQ->complete is called from the channel's
+   dispatcher thread, or REQ->done is up'd if COMPLETE is null.
+   REQ must stay allocated until then. */
+void disk_submit(struct disk_request *req) {
     struct channel *c;
+    enum intr_level old_level;
 
-    ASSERT(d != NULL);
-    ASSERT(buffer != NULL);
+    ASSERT(req != NULL);
+    ASSERT(req->disk != NULL);
+    ASSERT(req->buffer != NULL);
+    ASSERT(req->cnt > 0);
+    ASSERT(req->sector + req->cnt <= req->disk->capacity);
 
-    c = d->channel;
-    lock_acquire(&c->lock);
-    select_sector(d, sec_no);
-    issue_pio_command(c, CMD_WRITE_SECTOR_RETRY);
-    if (!wait_while_busy(d))
-        PANIC("%s: disk write failed, sector=%" PRDSNu, d->name, sec_no);
-    output_sector(c, buffer);
-    sema_down(&c->completion_wait);
-    d->write_cnt++;
-    lock_release(&c->lock);
+    c = req->disk->channel;
+    sema_init(&req->done, 0);
+
+    old_level = intr_disable();
+    list_insert_ordered(&c->queue, &req->elem, request_less, NULL);
+    intr_set_level(old_level);
+    sema_up(&c->pending);
+}
+
+/* Orders requests by starting sector, for the elevator. */
+static bool request_less(const struct list_elem *a, const struct list_elem *b,
+                         void *aux UNUSED) {
+    return list_entry(a, struct disk_request, elem)->sector <
+           list_entry(b, struct disk_request, elem)->sector;
+}
+
+/* Removes the next request from C's queue in C-LOOK order--the
+   first at or above the last position served, wrapping to the
+   lowest sector--together with every queued request that extends
+   it contiguously on the same disk in the same direction, and
+   appends them all to RUN.  Returns the total sector count.
+   Interrupts must be off. */
+static size_t next_run(struct channel *c, struct list *run) {
+    struct disk_request *first = NULL, *last;
+    struct list_elem *e;
+    size_t total;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(!list_empty(&c->queue));
+
+    for (e = list_begin(&c->queue); e != list_end(&c->queue); e = list_next(e)) {
+        struct disk_request *r = list_entry(e, struct disk_request, elem);
+        if (r->sector >= c->head_pos) {
+            first = r;
+            break;
+        }
+    }
+    if (first == NULL)
+        first = list_entry(list_front(&c->queue), struct disk_request, elem);
+
+    e = list_remove(&first->elem);
+    list_push_back(run, &first->elem);
+    last = first;
+    total = first->cnt;
+
+    /* Merge requests that start where the run ends.  The queue is
+       sorted, so anything past the run's end cannot extend it. */
+    while (e != list_end(&c->queue)) {
+        struct disk_request *r = list_entry(e, struct disk_request, elem);
+        disk_sector_t end = last->sector + last->cnt;
+
+        if (r->sector > end)
+            break;
+        if (r->sector == end && r->disk == first->disk && r->write == first->write &&
+            total + r->cnt <= MAX_SECTORS_PER_CMD && sema_try_down(&c->pending)) {
+            e = list_remove(e);
+            list_push_back(run, &r->elem);
+            last = r;
+            total += r->cnt;
+        } else
+            e = list_next(e);
+    }
+    c->head_pos = last->sector + last->cnt;
+    return total;
+}
+
+/* Moves the TOTAL sectors of RUN, whose requests are contiguous
+   on one disk, with as few commands as possible.  Each request's
+   buffer receives or supplies its own part of the data. */
+static void transfer_run(struct channel *c, struct list *run, size_t total) {
+    struct disk_request *first = list_entry(list_front(run), struct disk_request, elem);
+    struct disk *d = first->disk;
+    bool write = first->write;
+    struct list_elem *cur = list_begin(run);
+    size_t cur_ofs = 0;
+    disk_sector_t sec_no = first->sector;
+    uint8_t cmd;
+    size_t block = transfer_block(d, write, &cmd);
+
+    while (total > 0) {
+        size_t cmd_cnt = total < MAX_SECTORS_PER_CMD ? total : MAX_SECTORS_PER_CMD;
+        size_t done;
+
+        select_sectors(d, sec_no, cmd_cnt);
+        issue_pio_command(c, cmd);
+        for (done = 0; done < cmd_cnt;) {
+            size_t n = cmd_cnt - done < block ? cmd_cnt - done : block;
+
+            if (!write)
+                sema_down(&c->completion_wait);
+            if (!wait_while_busy(d))
+                PANIC("%s: disk %s failed, sector=%" PRDSNu, d->name, write ? "write" : "read",
+                      (disk_sector_t)(sec_no + done));
+            for (done += n; n > 0; n--) {
+                struct disk_request *r = list_entry(cur, struct disk_request, elem);
+                uint8_t *sector = (uint8_t *)r->buffer + cur_ofs * DISK_SECTOR_SIZE;
+
+                if (write)
+                    output_sector(c, sector);
+                else
+                    input_sector(c, sector);
+                if (++cur_ofs == r->cnt) {
+                    cur = list_next(cur);
+                    cur_ofs = 0;
+                }
+            }
+            if (write)
+                sema_down(&c->completion_wait);
+        }
+        if (write)
+            d->write_cnt += cmd_cnt;
+        else
+            d->read_cnt += cmd_cnt;
+        sec_no += cmd_cnt;
+        total -= cmd_cnt;
+    }
+}
+
+/* Per-channel dispatcher.  Interrupts from the controller only
+   wake this thread through completion_wait; it drives the PIO
+   transfers and completes the requests. */
+static void disk_dispatcher(void *channel_) {
+    struct channel *c = channel_;
+
+    for (;;) {
+        struct list run;
+        enum intr_level old_level;
+        size_t total;
+
+        sema_down(&c->pending);
+        list_init(&run);
+        old_level = intr_disable();
+        total = next_run(c, &run);
+        intr_set_level(old_level);
+
+        lock_acquire(&c->lock);
+        transfer_run(c, &run, total);
+        lock_release(&c->lock);
+
+        while (!list_empty(&run)) {
+            struct disk_request *r = list_entry(list_pop_front(&run), struct disk_request, elem);
+            if (r->complete != NULL)
+                r->complete(r);
+            else
+                sema_up(&r->done);
+        }
+    }
 }
 
 /* Disk detection and identification. */
@@ -354,6 +568,10 @@ static void identify_ata_device(struct disk *d) {
     /* Calculate capacity. */
     d->capacity = id[60] | ((uint32_t)id[61] << 16);
 
+    /* Word 47 gives the largest DRQ block READ/WRITE MULTIPLE
+       supports; use all of it. */
+    set_multiple_mode(d, id[47] & 0xff);
+
     /* Print identification message. */
     printf("%s: detected %'" PRDSNu " sector (", d->name, d->capacity);
     if (d->capacity > 1024 / DISK_SECTOR_SIZE * 1024 * 1024)
@@ -405,6 +623,37 @@ static void select_sector(struct disk *d, disk_sector_t sec_no) {
     outb(reg_device(c), DEV_MBS | DEV_LBA | (d->dev_no == 1 ? DEV_DEV : 0) | (sec_no >> 24));
 }
 
+/* As select_sector(), but for a transfer of CNT sectors starting
+   at SEC_NO.  CNT must be between 1 and MAX_SECTORS_PER_CMD. */
+static void select_sectors(struct disk *d, disk_sector_t sec_no, size_t cnt) {
+    struct channel *c = d->channel;
+
+    ASSERT(cnt >= 1 && cnt <= MAX_SECTORS_PER_CMD);
+    ASSERT(sec_no + cnt <= d->capacity);
+
+    select_sector(d, sec_no);
+    outb(reg_nsect(c), cnt == MAX_SECTORS_PER_CMD ? 0 : cnt);
+}
+
+/* Sets the DRQ block size of disk D to CNT sectors with SET
+   MULTIPLE MODE.  Leaves D on single-sector commands if CNT is 0
+   or the disk rejects it. */
+static void set_multiple_mode(struct disk *d, int cnt) {
+    struct channel *c = d->channel;
+
+    d->multiple_cnt = 0;
+    if (cnt == 0)
+        return;
+
+    select_device_wait(d);
+    outb(reg_nsect(c), cnt);
+    issue_pio_command(c, CMD_SET_MULTIPLE_MODE);
+    sema_down(&c->completion_wait);
+    wait_while_busy(d);
+    if (!(inb(reg_status(c)) & STA_ERR))
+        d->multiple_cnt = cnt;
+}
+
 /* Writes COMMAND to channel C and prepares for receiving a
    completion interrupt. */
 static void issue_pio_command(struct channel *c, uint8_t command) {
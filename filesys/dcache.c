@@ -0,0 +1,176 @@
+#include "filesys/dcache.h"
+
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "filesys/directory.h"
+#include "threads/synch.h"
+
+/* Directory entry cache.
+ *
+ * Remembers the result of recent name lookups as (directory inode
+ * sector, name) -> inode sector, so that opening the same path
+ * again needs neither directory reads nor a directory index.
+ * Names that were looked up and not found are remembered too, as
+ * negative entries.  The directory code keeps the cache in step
+ * with every entry it adds or removes. */
+
+/* A cached name. */
+struct dentry {
+    struct hash_elem hash_elem; /* Element in dentries. */
+    struct list_elem lru_elem;  /* Element in lru or free_dentries. */
+    disk_sector_t parent;       /* Sector of the directory's inode. */
+    char name[NAME_MAX + 1];    /* Name within PARENT. */
+    bool found;                 /* False for a negative entry. */
+    disk_sector_t sector;       /* Inode sector of NAME, if FOUND. */
+};
+
+static struct dentry dentries[DCACHE_SIZE];
+static struct hash dentry_table;  /* Dentries in use. */
+static struct list lru;           /* Dentries in use, most recent first. */
+static struct list free_dentries; /* Dentries not in use. */
+static struct lock dcache_lock;
+
+/* Statistics. */
+static unsigned long long hit_cnt, negative_hit_cnt, miss_cnt;
+
+static uint64_t dentry_hash(const struct hash_elem *e, void *aux UNUSED) {
+    const struct dentry *d = hash_entry(e, struct dentry, hash_elem);
+    return hash_string(d->name) ^ hash_int(d->parent);
+}
+
+static bool dentry_less(const struct hash_elem *a_, const struct hash_elem *b_,
+                        void *aux UNUSED) {
+    const struct dentry *a = hash_entry(a_, struct dentry, hash_elem);
+    const struct dentry *b = hash_entry(b_, struct dentry, hash_elem);
+
+    if (a->parent != b->parent)
+        return a->parent < b->parent;
+    return strcmp(a->name, b->name) < 0;
+}
+
+/* Initializes the directory entry cache. */
+void dcache_init(void) {
+    size_t i;
+
+    if (!hash_init(&dentry_table, dentry_hash, dentry_less, NULL))
+        PANIC("directory entry cache creation failed");
+    list_init(&lru);
+    list_init(&free_dentries);
+    for (i = 0; i < DCACHE_SIZE; i++)
+        list_push_back(&free_dentries, &dentries[i].lru_elem);
+    lock_init(&dcache_lock);
+    lock_register(&dcache_lock, "dcache");
+}
+
+/* Returns the dentry for NAME in PARENT, or a null pointer.
+ * The caller must hold dcache_lock. */
+static struct dentry *find(disk_sector_t parent, const char *name) {
+    struct dentry key;
+    struct hash_elem *e;
+
+    key.parent = parent;
+    strlcpy(key.name, name, sizeof key.name);
+    e = hash_find(&dentry_table, &key.hash_elem);
+    return e != NULL ? hash_entry(e, struct dentry, hash_elem) : NULL;
+}
+
+/* Drops D from the cache.  The caller must hold dcache_lock. */
+static void drop(struct dentry *d) {
+    hash_delete(&dentry_table, &d->hash_elem);
+    list_remove(&d->lru_elem);
+    list_push_back(&free_dentries, &d->lru_elem);
+}
+
+/* Looks up NAME in the directory whose inode is in PARENT.
+ * Returns false if the cache does not know.  Otherwise returns
+ * true and sets *FOUND to whether NAME exists and, if it does,
+ * *SECTORP to its inode sector. */
+bool dcache_lookup(disk_sector_t parent, const char *name, bool *found, disk_sector_t *sectorp) {
+    struct dentry *d;
+
+    if (strlen(name) > NAME_MAX)
+        return false;
+
+    lock_acquire(&dcache_lock);
+    d = find(parent, name);
+    if (d != NULL) {
+        list_remove(&d->lru_elem);
+        list_push_front(&lru, &d->lru_elem);
+        *found = d->found;
+        *sectorp = d->sector;
+        if (d->found)
+            hit_cnt++;
+        else
+            negative_hit_cnt++;
+    } else
+        miss_cnt++;
+    lock_release(&dcache_lock);
+    return d != NULL;
+}
+
+/* Records that NAME in PARENT is the inode in SECTOR if FOUND, or
+ * does not exist otherwise, replacing the least recently used
+ * entry if the cache is full.  The caller must keep the directory
+ * from changing meanwhile. */
+void dcache_insert(disk_sector_t parent, const char *name, bool found, disk_sector_t sector) {
+    struct dentry *d;
+
+    if (strlen(name) > NAME_MAX)
+        return;
+
+    lock_acquire(&dcache_lock);
+    d = find(parent, name);
+    if (d != NULL)
+        list_remove(&d->lru_elem);
+    else {
+        if (list_empty(&free_dentries))
+            drop(list_entry(list_back(&lru), struct dentry, lru_elem));
+        d = list_entry(list_pop_front(&free_dentries), struct dentry, lru_elem);
+        d->parent = parent;
+        strlcpy(d->name, name, sizeof d->name);
+        hash_insert(&dentry_table, &d->hash_elem);
+    }
+    d->found = found;
+    d->sector = found ? sector : 0;
+    list_push_front(&lru, &d->lru_elem);
+    lock_release(&dcache_lock);
+}
+
+/* Forgets anything cached about NAME in PARENT. */
+void dcache_invalidate(disk_sector_t parent, const char *name) {
+    struct dentry *d;
+
+    if (strlen(name) > NAME_MAX)
+        return;
+
+    lock_acquire(&dcache_lock);
+    d = find(parent, name);
+    if (d != NULL)
+        drop(d);
+    lock_release(&dcache_lock);
+}
+
+/* Forgets every name cached for the directory in PARENT, whose
+ * sector may then be reused for something else. */
+void dcache_purge_dir(disk_sector_t parent) {
+    struct list_elem *e, *next;
+
+    lock_acquire(&dcache_lock);
+    for (e = list_begin(&lru); e != list_end(&lru); e = next) {
+        struct dentry *d = list_entry(e, struct dentry, lru_elem);
+        next = list_next(e);
+        if (d->parent == parent)
+            drop(d);
+    }
+    lock_release(&dcache_lock);
+}
+
+/* Prints directory entry cache statistics. */
+void dcache_print_stats(void) {
+    printf("Dentry cache: %llu hits, %llu negative hits, %llu misses\n", hit_cnt,
+           negative_hit_cnt, miss_cnt);
+}
@@ -1,12 +1,15 @@
 #include "filesys/directory.h"
 
+#include <hash.h>
 #include <list.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "filesys/dcache.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* A directory. */
 struct dir {
@@ -19,12 +22,224 @@ struct dir_entry {
     disk_sector_t inode_sector; /* Sector number of header. */
     char name[NAME_MAX + 1];    /* Null terminated file name. */
     bool in_use;                /* In use or free? */
+    bool is_dir;                /* Names a directory? */
 };
 
+/* In-memory index of a directory's entries, built on first use
+ * and attached to the directory's inode, so it lives as long as
+ * the inode stays in memory.  Lookups, additions and removals then
+ * cost one hash probe instead of a scan over every entry. */
+struct dir_index {
+    disk_sector_t sector;   /* Sector of the directory's inode. */
+    struct lock lock;       /* Guards the index and entry writes. */
+    struct hash names;      /* Slots in use, by name. */
+    struct list free_slots; /* Slots not in use. */
+    off_t end;              /* Offset just past the last slot. */
+};
+
+/* One directory entry slot in a dir_index. */
+struct dir_slot {
+    struct hash_elem hash_elem; /* Element in names, if in use. */
+    struct list_elem list_elem; /* Element in free_slots, if not. */
+    off_t ofs;                  /* Byte offset of the entry. */
+    struct dir_entry e;         /* Copy of the entry. */
+};
+
+/* Entries read at a time while building an index. */
+#define INDEX_READ_CNT 32
+
+static uint64_t slot_hash(const struct hash_elem *e, void *aux UNUSED) {
+    return hash_string(hash_entry(e, struct dir_slot, hash_elem)->e.name);
+}
+
+static bool slot_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED) {
+    return strcmp(hash_entry(a, struct dir_slot, hash_elem)->e.name,
+                  hash_entry(b, struct dir_slot, hash_elem)->e.name) < 0;
+}
+
+static void slot_free(struct hash_elem *e, void *aux UNUSED) {
+    free(hash_entry(e, struct dir_slot, hash_elem));
+}
+
+/* Frees INDEX.  Called when its inode leaves memory, after which
+ * the directory entry cache must not vouch for its names either,
+ * since the directory may be gone. */
+static void index_destroy(void *index_) {
+    struct dir_index *index = index_;
+
+    dcache_purge_dir(index->sector);
+    hash_destroy(&index->names, slot_free);
+    while (!list_empty(&index->free_slots))
+        free(list_entry(list_pop_front(&index->free_slots), struct dir_slot, list_elem));
+    free(index);
+}
+
+/* Reads every entry of INODE into a new index.
+ * Returns a null pointer if memory runs out. */
+static struct dir_index *index_build(struct inode *inode) {
+    struct dir_index *index = malloc(sizeof *index);
+    struct dir_entry *buf = malloc(INDEX_READ_CNT * sizeof *buf);
+    off_t ofs = 0;
+
+    if (index == NULL || buf == NULL || !hash_init(&index->names, slot_hash, slot_less, NULL)) {
+        free(index);
+        free(buf);
+        return NULL;
+    }
+    index->sector = inode_get_inumber(inode);
+    lock_init(&index->lock);
+    list_init(&index->free_slots);
+
+    for (;;) {
+        off_t got = inode_read_at(inode, buf, INDEX_READ_CNT * sizeof *buf, ofs);
+        size_t i, cnt = got / sizeof *buf;
+
+        for (i = 0; i < cnt; i++, ofs += sizeof *buf) {
+            struct dir_slot *slot = malloc(sizeof *slot);
+            if (slot == NULL) {
+                free(buf);
+                index_destroy(index);
+                return NULL;
+            }
+            slot->ofs = ofs;
+            slot->e = buf[i];
+            if (!slot->e.in_use || hash_insert(&index->names, &slot->hash_elem) != NULL)
+                list_push_back(&index->free_slots, &slot->list_elem);
+        }
+        if (cnt < INDEX_READ_CNT)
+            break;
+    }
+    index->end = ofs;
+    free(buf);
+    return index;
+}
+
+/* Returns DIR's index, building it if necessary, or a null pointer
+ * if there is not enough memory, in which case the caller falls
+ * back to scanning the entries on disk. */
+static struct dir_index *get_index(const struct dir *dir) {
+    struct dir_index *index = inode_get_private(dir->inode);
+    struct dir_index *cur;
+
+    if (index != NULL)
+        return index;
+    index = index_build(dir->inode);
+    if (index == NULL)
+        return NULL;
+
+    /* Another thread may have attached an index first. */
+    cur = inode_set_private(dir->inode, index, index_destroy);
+    if (cur != index)
+        index_destroy(index);
+    return cur;
+}
+
+/* Returns the slot for NAME in INDEX, or a null pointer.
+ * The caller must hold INDEX's lock. */
+static struct dir_slot *index_find(struct dir_index *index, const char *name) {
+    struct dir_slot key;
+    struct hash_elem *e;
+
+    strlcpy(key.e.name, name, sizeof key.e.name);
+    e = hash_find(&index->names, &key.hash_elem);
+    return e != NULL ? hash_entry(e, struct dir_slot, hash_elem) : NULL;
+}
+
+/* Adds NAME for the inode in INODE_SECTOR, a directory if IS_DIR,
+ * to directory INODE through its INDEX, reusing a free slot if
+ * there is one and appending a new one otherwise.  NAME must be
+ * valid.
+ * Returns true if successful, false if NAME is in use or the
+ * entry cannot be written. */
+static bool index_add(struct dir_index *index, struct inode *inode, const char *name,
+                      disk_sector_t inode_sector, bool is_dir) {
+    struct dir_slot *slot;
+    bool fresh = false;
+    bool success = false;
+
+    lock_acquire(&index->lock);
+    if (index_find(index, name) != NULL)
+        goto done;
+
+    if (!list_empty(&index->free_slots))
+        slot = list_entry(list_pop_front(&index->free_slots), struct dir_slot, list_elem);
+    else {
+        slot = malloc(sizeof *slot);
+        if (slot == NULL)
+            goto done;
+        slot->ofs = index->end;
+        fresh = true;
+    }
+
+    slot->e.in_use = true;
+    strlcpy(slot->e.name, name, sizeof slot->e.name);
+    slot->e.inode_sector = inode_sector;
+    slot->e.is_dir = is_dir;
+    success = inode_write_at(inode, &slot->e, sizeof slot->e, slot->ofs) == sizeof slot->e;
+    if (success) {
+        hash_insert(&index->names, &slot->hash_elem);
+        dcache_insert(index->sector, name, true, inode_sector);
+        if (fresh)
+            index->end += sizeof slot->e;
+    } else {
+        slot->e.in_use = false;
+        if (fresh)
+            free(slot);
+        else
+            list_push_front(&index->free_slots, &slot->list_elem);
+    }
+
+done:
+    lock_release(&index->lock);
+    return success;
+}
+
+/* Removes the entry for NAME from directory INODE through its
+ * INDEX and marks the named inode for deletion.
+ * Returns true if successful, false if there is no such entry or
+ * it cannot be erased. */
+static bool index_remove(struct dir_index *index, struct inode *inode, const char *name) {
+    struct dir_slot *slot;
+    struct inode *target = NULL;
+    bool success = false;
+
+    if (strlen(name) > NAME_MAX)
+        return false;
+
+    lock_acquire(&index->lock);
+    slot = index_find(index, name);
+    if (slot == NULL)
+        goto done;
+
+    /* Open inode. */
+    target = inode_open(slot->e.inode_sector);
+    if (target == NULL)
+        goto done;
+
+    /* Erase directory entry. */
+    slot->e.in_use = false;
+    if (inode_write_at(inode, &slot->e, sizeof slot->e, slot->ofs) != sizeof slot->e) {
+        slot->e.in_use = true;
+        goto done;
+    }
+    hash_delete(&index->names, &slot->hash_elem);
+    list_push_front(&index->free_slots, &slot->list_elem);
+    dcache_insert(index->sector, name, false, 0);
+
+    /* Remove inode. */
+    inode_remove(target);
+    success = true;
+
+done:
+    lock_release(&index->lock);
+    inode_close(target);
+    return success;
+}
+
 /* Creates a directory with space for ENTRY_CNT entries in the
  * given SECTOR.  Returns true if successful, false on failure. */
 bool dir_create(disk_sector_t sector, size_t entry_cnt) {
-    return inode_create(sector, entry_cnt * sizeof(struct dir_entry));
+    return inode_create(sector, entry_cnt * sizeof(struct dir_entry), true);
 }
 
 /* Opens and returns the directory for the given INODE, of which
@@ -73,12 +288,34 @@ struct inode *dir_get_inode(struct dir *dir) {
  * directory entry if OFSP is non-null.
  * otherwise, returns false and ignores EP and OFSP. */
 static bool lookup(const struct dir *dir, const char *name, struct dir_entry *ep, off_t *ofsp) {
+    struct dir_index *index;
     struct dir_entry e;
     size_t ofs;
 
     ASSERT(dir != NULL);
     ASSERT(name != NULL);
 
+    index = get_index(dir);
+    if (index != NULL) {
+        struct dir_slot *slot;
+        bool found;
+
+        if (strlen(name) > NAME_MAX)
+            return false;
+        lock_acquire(&index->lock);
+        slot = index_find(index, name);
+        found = slot != NULL;
+        dcache_insert(index->sector, name, found, found ? slot->e.inode_sector : 0);
+        if (found) {
+            if (ep != NULL)
+                *ep = slot->e;
+            if (ofsp != NULL)
+                *ofsp = slot->ofs;
+        }
+        lock_release(&index->lock);
+        return found;
+    }
+
     for (ofs = 0; inode_read_at(dir->inode, &e, sizeof e, ofs) == sizeof e; ofs += sizeof e)
         if (e.in_use && !strcmp(name, e.name)) {
             if (ep != NULL)
@@ -96,11 +333,15 @@ static bool lookup(const struct dir *dir, const char *name, struct dir_entry *ep
  * a null pointer.  The caller must close *INODE. */
 bool dir_lookup(const struct dir *dir, const char *name, struct inode **inode) {
     struct dir_entry e;
+    disk_sector_t sector;
+    bool found;
 
     ASSERT(dir != NULL);
     ASSERT(name != NULL);
 
-    if (lookup(dir, name, &e, NULL))
+    if (dcache_lookup(inode_get_inumber(dir->inode), name, &found, &sector))
+        *inode = found ? inode_open(sector) : NULL;
+    else if (lookup(dir, name, &e, NULL))
         *inode = inode_open(e.inode_sector);
     else
         *inode = NULL;
@@ -110,11 +351,12 @@ bool dir_lookup(const struct dir *dir, const char *name, struct inode **inode) {
 
 /* Adds a file named NAME to DIR, which must not already contain a
  * file by that name.  The file's inode is in sector
- * INODE_SECTOR.
+ * INODE_SECTOR, and IS_DIR tells whether it holds a directory.
  * Returns true if successful, false on failure.
  * Fails if NAME is invalid (i.e. too long) or a disk or memory
  * error occurs. */
-bool dir_add(struct dir *dir, const char *name, disk_sector_t inode_sector) {
+bool dir_add(struct dir *dir, const char *name, disk_sector_t inode_sector, bool is_dir) {
+    struct dir_index *index;
     struct dir_entry e;
     off_t ofs;
     bool success = false;
@@ -126,6 +368,10 @@ bool dir_add(struct dir *dir, const char *name, disk_sector_t inode_sector) {
     if (*name == '\0' || strlen(name) > NAME_MAX)
         return false;
 
+    index = get_index(dir);
+    if (index != NULL)
+        return index_add(index, dir->inode, name, inode_sector, is_dir);
+
     /* Check that NAME is not in use. */
     if (lookup(dir, name, NULL, NULL))
         goto done;
@@ -145,7 +391,9 @@ bool dir_add(struct dir *dir, const char *name, disk_sector_t inode_sector) {
     e.in_use = true;
     strlcpy(e.name, name, sizeof e.name);
     e.inode_sector = inode_sector;
+    e.is_dir = is_dir;
     success = inode_write_at(dir->inode, &e, sizeof e, ofs) == sizeof e;
+    dcache_invalidate(inode_get_inumber(dir->inode), name);
 
 done:
     return success;
@@ -155,6 +403,7 @@ done:
  * Returns true if successful, false on failure,
  * which occurs only if there is no file with the given NAME. */
 bool dir_remove(struct dir *dir, const char *name) {
+    struct dir_index *index;
     struct dir_entry e;
     struct inode *inode = NULL;
     bool success = false;
@@ -163,6 +412,10 @@ bool dir_remove(struct dir *dir, const char *name) {
     ASSERT(dir != NULL);
     ASSERT(name != NULL);
 
+    index = get_index(dir);
+    if (index != NULL)
+        return index_remove(index, dir->inode, name);
+
     /* Find directory entry. */
     if (!lookup(dir, name, &e, &ofs))
         goto done;
@@ -176,6 +429,7 @@ bool dir_remove(struct dir *dir, const char *name) {
     e.in_use = false;
     if (inode_write_at(dir->inode, &e, sizeof e, ofs) != sizeof e)
         goto done;
+    dcache_invalidate(inode_get_inumber(dir->inode), name);
 
     /* Remove inode. */
     inode_remove(inode);
@@ -201,3 +455,29 @@ bool dir_readdir(struct dir *dir, char name[NAME_MAX + 1]) {
     }
     return false;
 }
+
+/* Reads directory entries of DIR in bulk, starting at its current
+ * position, and passes each one in use to EMIT along with AUX.
+ * Stops at the end of the directory or when EMIT returns false,
+ * in which case the entry it refused is read again next time.
+ * Returns the number of entries EMIT accepted. */
+int dir_readdir_each(struct dir *dir, dir_emit_func *emit, void *aux) {
+    struct dir_entry buf[INDEX_READ_CNT];
+    int emitted = 0;
+
+    for (;;) {
+        off_t got = inode_read_at(dir->inode, buf, sizeof buf, dir->pos);
+        size_t i, cnt = got / sizeof *buf;
+
+        for (i = 0; i < cnt; i++) {
+            if (buf[i].in_use) {
+                if (!emit(buf[i].inode_sector, buf[i].name, buf[i].is_dir, aux))
+                    return emitted;
+                emitted++;
+            }
+            dir->pos += sizeof *buf;
+        }
+        if (cnt < INDEX_READ_CNT)
+            return emitted;
+    }
+}
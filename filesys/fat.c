@@ -1,17 +1,21 @@
 #include "filesys/fat.h"
 
+#include <bitmap.h>
+#include <round.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "devices/disk.h"
 #include "filesys/filesys.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/vaddr.h"
 
 /* Should be less than DISK_SECTOR_SIZE */
 struct fat_boot {
     unsigned int magic;
-    unsigned int sectors_per_cluster; /* Fixed to 1 */
+    unsigned int sectors_per_cluster; /* Chosen at format time */
     unsigned int total_sectors;
     unsigned int fat_start;
     unsigned int fat_sectors; /* Size of FAT in sectors. */
@@ -24,19 +28,36 @@ struct fat_fs {
     unsigned int *fat;
     unsigned int fat_length;
     disk_sector_t data_start;
-    cluster_t last_clst;
+    cluster_t last_clst;          /* Where the search for a free cluster starts. */
+    struct bitmap *used_clusters; /* One bit per cluster, set if in use. */
+    struct bitmap *dirty_sectors; /* One bit per FAT sector, set if modified. */
+    uint8_t *flush_buf;           /* FAT_FLUSH_SECTORS sectors for fat_flush(). */
     struct lock write_lock;
 };
 
+/* Most FAT sectors fat_flush() writes with one transfer. */
+#define FAT_FLUSH_SECTORS (PGSIZE / DISK_SECTOR_SIZE)
+
+/* FAT entries per FAT sector. */
+#define CLUSTERS_PER_SECTOR (DISK_SECTOR_SIZE / sizeof(cluster_t))
+
 static struct fat_fs *fat_fs;
 
+unsigned int fat_format_cluster_sectors = SECTORS_PER_CLUSTER;
+
 void fat_boot_create(void);
 void fat_fs_init(void);
+static void fat_scan_free(void);
 
 void fat_init(void) {
     fat_fs = calloc(1, sizeof(struct fat_fs));
     if (fat_fs == NULL)
         PANIC("FAT init failed");
+    lock_init(&fat_fs->write_lock);
+    lock_register(&fat_fs->write_lock, "FAT");
+    fat_fs->flush_buf = palloc_get_page(0);
+    if (fat_fs->flush_buf == NULL)
+        PANIC("FAT init failed");
 
     // Read boot sector from the disk
     unsigned int *bounce = malloc(DISK_SECTOR_SIZE);
@@ -52,31 +73,31 @@ void fat_init(void) {
     fat_fs_init();
 }
 
+/* Allocates a zeroed in-memory FAT.  It covers every FAT sector
+ * in full, so that sectors move between it and the disk without
+ * bounce buffers. */
+static void fat_alloc(void) {
+    unsigned int *fat = calloc(fat_fs->bs.fat_sectors, DISK_SECTOR_SIZE);
+    unsigned int *old;
+    if (fat == NULL)
+        PANIC("FAT allocation failed");
+
+    /* fat_flush() may be copying out of the old one. */
+    lock_acquire(&fat_fs->write_lock);
+    old = fat_fs->fat;
+    fat_fs->fat = fat;
+    lock_release(&fat_fs->write_lock);
+    free(old);
+}
+
 void fat_open(void) {
-    fat_fs->fat = calloc(fat_fs->fat_length, sizeof(cluster_t));
-    if (fat_fs->fat == NULL)
-        PANIC("FAT load failed");
-
-    // Load FAT directly from the disk
-    uint8_t *buffer = (uint8_t *)fat_fs->fat;
-    off_t bytes_read = 0;
-    off_t bytes_left = sizeof(fat_fs->fat);
-    const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof(cluster_t);
-    for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-        bytes_left = fat_size_in_bytes - bytes_read;
-        if (bytes_left >= DISK_SECTOR_SIZE) {
-            disk_read(filesys_disk, fat_fs->bs.fat_start + i, buffer + bytes_read);
-            bytes_read += DISK_SECTOR_SIZE;
-        } else {
-            uint8_t *bounce = malloc(DISK_SECTOR_SIZE);
-            if (bounce == NULL)
-                PANIC("FAT load failed");
-            disk_read(filesys_disk, fat_fs->bs.fat_start + i, bounce);
-            memcpy(buffer + bytes_read, bounce, bytes_left);
-            bytes_read += bytes_left;
-            free(bounce);
-        }
-    }
+    fat_alloc();
+
+    // Load FAT directly from the disk, as few commands as possible
+    disk_read_multiple(filesys_disk, fat_fs->bs.fat_start, fat_fs->fat, fat_fs->bs.fat_sectors);
+    bitmap_set_all(fat_fs->dirty_sectors, false);
+
+    fat_scan_free();
 }
 
 void fat_close(void) {
@@ -88,25 +109,38 @@ void fat_close(void) {
     disk_write(filesys_disk, FAT_BOOT_SECTOR, bounce);
     free(bounce);
 
-    // Write FAT directly to the disk
-    uint8_t *buffer = (uint8_t *)fat_fs->fat;
-    off_t bytes_wrote = 0;
-    off_t bytes_left = sizeof(fat_fs->fat);
-    const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof(cluster_t);
-    for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-        bytes_left = fat_size_in_bytes - bytes_wrote;
-        if (bytes_left >= DISK_SECTOR_SIZE) {
-            disk_write(filesys_disk, fat_fs->bs.fat_start + i, buffer + bytes_wrote);
-            bytes_wrote += DISK_SECTOR_SIZE;
-        } else {
-            bounce = calloc(1, DISK_SECTOR_SIZE);
-            if (bounce == NULL)
-                PANIC("FAT close failed");
-            memcpy(bounce, buffer + bytes_wrote, bytes_left);
-            disk_write(filesys_disk, fat_fs->bs.fat_start + i, bounce);
-            bytes_wrote += bytes_left;
-            free(bounce);
+    // Write the FAT sectors changed since the last flush
+    fat_flush();
+}
+
+/* Writes the FAT sectors modified since they were last written
+ * back to disk, batching runs of adjacent sectors into single
+ * transfers.  Each run is copied out under the lock and written
+ * without it, so allocation is not held up by the disk.  Does
+ * nothing if the FAT is not loaded. */
+void fat_flush(void) {
+    if (fat_fs == NULL || fat_fs->fat == NULL)
+        return;
+
+    for (;;) {
+        size_t start, cnt;
+
+        lock_acquire(&fat_fs->write_lock);
+        start = bitmap_scan(fat_fs->dirty_sectors, 0, 1, true);
+        if (start == BITMAP_ERROR) {
+            lock_release(&fat_fs->write_lock);
+            return;
         }
+        for (cnt = 1; cnt < FAT_FLUSH_SECTORS && start + cnt < fat_fs->bs.fat_sectors &&
+                      bitmap_test(fat_fs->dirty_sectors, start + cnt);
+             cnt++)
+            continue;
+        memcpy(fat_fs->flush_buf, (uint8_t *)fat_fs->fat + start * DISK_SECTOR_SIZE,
+               cnt * DISK_SECTOR_SIZE);
+        bitmap_set_multiple(fat_fs->dirty_sectors, start, cnt, false);
+        lock_release(&fat_fs->write_lock);
+
+        disk_write_multiple(filesys_disk, fat_fs->bs.fat_start + start, fat_fs->flush_buf, cnt);
     }
 }
 
@@ -115,10 +149,11 @@ void fat_create(void) {
     fat_boot_create();
     fat_fs_init();
 
-    // Create FAT table
-    fat_fs->fat = calloc(fat_fs->fat_length, sizeof(cluster_t));
-    if (fat_fs->fat == NULL)
-        PANIC("FAT creation failed");
+    // Create FAT table; every sector of it has yet to be written
+    fat_alloc();
+    bitmap_set_all(fat_fs->dirty_sectors, true);
+
+    fat_scan_free();
 
     // Set up ROOT_DIR_CLST
     fat_put(ROOT_DIR_CLUSTER, EOChain);
@@ -132,13 +167,15 @@ void fat_create(void) {
 }
 
 void fat_boot_create(void) {
-    unsigned int fat_sectors =
-        (disk_size(filesys_disk) - 1) /
-            (DISK_SECTOR_SIZE / sizeof(cluster_t) * SECTORS_PER_CLUSTER + 1) +
-        1;
+    unsigned int spc = fat_format_cluster_sectors;
+    unsigned int fat_sectors;
+
+    if (spc == 0 || spc > MAX_SECTORS_PER_CLUSTER || (spc & (spc - 1)) != 0)
+        PANIC("invalid cluster size: %u sectors", spc);
+    fat_sectors = (disk_size(filesys_disk) - 1) / (CLUSTERS_PER_SECTOR * spc + 1) + 1;
     fat_fs->bs = (struct fat_boot){
         .magic = FAT_MAGIC,
-        .sectors_per_cluster = SECTORS_PER_CLUSTER,
+        .sectors_per_cluster = spc,
         .total_sectors = disk_size(filesys_disk),
         .fat_start = 1,
         .fat_sectors = fat_sectors,
@@ -147,37 +184,245 @@ void fat_boot_create(void) {
 }
 
 void fat_fs_init(void) {
-    /* TODO: Your code goes here. */
+    size_t max_entries = fat_fs->bs.fat_sectors * CLUSTERS_PER_SECTOR;
+
+    /* Clusters are numbered from 1; 0 means "no cluster".  They
+     * start on a multiple of their own size, so a page-sized
+     * cluster is also page aligned on disk. */
+    fat_fs->data_start = ROUND_UP(fat_fs->bs.fat_start + fat_fs->bs.fat_sectors,
+                                  fat_fs->bs.sectors_per_cluster);
+    fat_fs->fat_length =
+        (fat_fs->bs.total_sectors - fat_fs->data_start) / fat_fs->bs.sectors_per_cluster + 1;
+    if (fat_fs->fat_length > max_entries)
+        fat_fs->fat_length = max_entries;
+
+    if (fat_fs->used_clusters != NULL)
+        bitmap_destroy(fat_fs->used_clusters);
+    fat_fs->used_clusters = bitmap_create(fat_fs->fat_length);
+    if (fat_fs->used_clusters == NULL)
+        PANIC("FAT init failed");
+    if (fat_fs->dirty_sectors != NULL)
+        bitmap_destroy(fat_fs->dirty_sectors);
+    fat_fs->dirty_sectors = bitmap_create(fat_fs->bs.fat_sectors);
+    if (fat_fs->dirty_sectors == NULL)
+        PANIC("FAT init failed");
+    fat_fs->last_clst = ROOT_DIR_CLUSTER + 1;
+}
+
+/* Rebuilds the free cluster bitmap from the FAT, so that finding a
+ * free cluster later takes a bitmap search rather than a FAT scan. */
+static void fat_scan_free(void) {
+    cluster_t clst;
+
+    bitmap_set_all(fat_fs->used_clusters, false);
+    bitmap_mark(fat_fs->used_clusters, 0);
+    for (clst = 1; clst < fat_fs->fat_length; clst++)
+        if (fat_fs->fat[clst] != 0)
+            bitmap_mark(fat_fs->used_clusters, clst);
 }
 
 /*----------------------------------------------------------------------------*/
 /* FAT handling                                                               */
 /*----------------------------------------------------------------------------*/
 
+/* Sets the FAT entry for CLST to VAL, keeping the free cluster
+ * bitmap in step and marking the FAT sector dirty.  The caller must hold the write lock. */
+static void fat_set(cluster_t clst, cluster_t val) {
+    ASSERT(clst > 0 && clst < fat_fs->fat_length);
+
+    fat_fs->fat[clst] = val;
+    bitmap_set(fat_fs->used_clusters, clst, val != 0);
+    bitmap_mark(fat_fs->dirty_sectors, clst / CLUSTERS_PER_SECTOR);
+}
+
 /* Add a cluster to the chain.
  * If CLST is 0, start a new chain.
  * Returns 0 if fails to allocate a new cluster. */
 cluster_t fat_create_chain(cluster_t clst) {
-    /* TODO: Your code goes here. */
+    size_t new_clst;
+
+    lock_acquire(&fat_fs->write_lock);
+
+    /* Next fit: continue after the cluster handed out last, which
+     * also keeps a growing chain mostly contiguous. */
+    new_clst = bitmap_scan(fat_fs->used_clusters, fat_fs->last_clst, 1, false);
+    if (new_clst == BITMAP_ERROR)
+        new_clst = bitmap_scan(fat_fs->used_clusters, 1, 1, false);
+    if (new_clst == BITMAP_ERROR) {
+        lock_release(&fat_fs->write_lock);
+        return 0;
+    }
+
+    fat_set(new_clst, EOChain);
+    if (clst != 0)
+        fat_set(clst, new_clst);
+    fat_fs->last_clst = new_clst + 1 < fat_fs->fat_length ? new_clst + 1 : 1;
+
+    lock_release(&fat_fs->write_lock);
+    return new_clst;
 }
 
 /* Remove the chain of clusters starting from CLST.
  * If PCLST is 0, assume CLST as the start of the chain. */
 void fat_remove_chain(cluster_t clst, cluster_t pclst) {
-    /* TODO: Your code goes here. */
+    lock_acquire(&fat_fs->write_lock);
+    while (clst != 0 && clst != EOChain) {
+        cluster_t next = fat_fs->fat[clst];
+        fat_set(clst, 0);
+        clst = next;
+    }
+    if (pclst != 0)
+        fat_set(pclst, EOChain);
+    lock_release(&fat_fs->write_lock);
 }
 
 /* Update a value in the FAT table. */
 void fat_put(cluster_t clst, cluster_t val) {
-    /* TODO: Your code goes here. */
+    lock_acquire(&fat_fs->write_lock);
+    fat_set(clst, val);
+    lock_release(&fat_fs->write_lock);
 }
 
 /* Fetch a value in the FAT table. */
 cluster_t fat_get(cluster_t clst) {
-    /* TODO: Your code goes here. */
+    ASSERT(clst > 0 && clst < fat_fs->fat_length);
+    return fat_fs->fat[clst];
 }
 
 /* Covert a cluster # to a sector number. */
 disk_sector_t cluster_to_sector(cluster_t clst) {
-    /* TODO: Your code goes here. */
+    ASSERT(clst > 0 && clst < fat_fs->fat_length);
+    return fat_fs->data_start + (clst - 1) * fat_fs->bs.sectors_per_cluster;
+}
+
+/* Returns the number of sectors in a cluster. */
+unsigned int fat_cluster_sectors(void) {
+    return fat_fs->bs.sectors_per_cluster;
+}
+
+/* Converts a sector number to the cluster # holding it. */
+cluster_t sector_to_cluster(disk_sector_t sector) {
+    ASSERT(sector >= fat_fs->data_start);
+    return (sector - fat_fs->data_start) / fat_fs->bs.sectors_per_cluster + 1;
+}
+
+/*----------------------------------------------------------------------------*/
+/* Chain cache                                                                */
+/*----------------------------------------------------------------------------*/
+
+/* Initializes CHAIN as a handle on the chain starting at START,
+ * or an empty chain if START is 0. */
+void fat_chain_init(struct fat_chain *chain, cluster_t start) {
+    chain->start = start;
+    chain->tail = 0;
+    chain->length = 0;
+    chain->pos = 0;
+    chain->pos_clst = start;
+    chain->marks = NULL;
+    chain->mark_cnt = 0;
+    chain->mark_cap = 0;
+}
+
+/* Frees the memory CHAIN uses, leaving the chain itself alone. */
+void fat_chain_destroy(struct fat_chain *chain) {
+    free(chain->marks);
+    fat_chain_init(chain, 0);
+}
+
+/* Notes that cluster IDX of CHAIN is CLST, if that is the next
+ * mark CHAIN is missing.  Running out of memory only loses the
+ * mark. */
+static void chain_mark(struct fat_chain *chain, size_t idx, cluster_t clst) {
+    if (idx % FAT_CHAIN_MARK_GAP != 0 || idx / FAT_CHAIN_MARK_GAP != chain->mark_cnt)
+        return;
+    if (chain->mark_cnt == chain->mark_cap) {
+        size_t cap = chain->mark_cap ? chain->mark_cap * 2 : 8;
+        cluster_t *marks = realloc(chain->marks, cap * sizeof *marks);
+        if (marks == NULL)
+            return;
+        chain->marks = marks;
+        chain->mark_cap = cap;
+    }
+    chain->marks[chain->mark_cnt++] = clst;
+}
+
+/* Walks CHAIN from the known cluster nearest before cluster N,
+ * stopping at N or at the end of the chain.  Stores the index
+ * reached in *IDXP and returns the cluster there. */
+static cluster_t chain_walk(struct fat_chain *chain, size_t n, size_t *idxp) {
+    size_t idx = 0;
+    cluster_t clst = chain->start;
+
+    if (chain->mark_cnt > 0) {
+        size_t m = n / FAT_CHAIN_MARK_GAP;
+        if (m >= chain->mark_cnt)
+            m = chain->mark_cnt - 1;
+        idx = m * FAT_CHAIN_MARK_GAP;
+        clst = chain->marks[m];
+    }
+    if (chain->pos_clst != 0 && chain->pos > idx && chain->pos <= n) {
+        idx = chain->pos;
+        clst = chain->pos_clst;
+    }
+    chain_mark(chain, idx, clst);
+
+    while (idx < n) {
+        cluster_t next = fat_get(clst);
+        if (next == EOChain || next == 0)
+            break;
+        clst = next;
+        chain_mark(chain, ++idx, clst);
+    }
+
+    chain->pos = idx;
+    chain->pos_clst = clst;
+    *idxp = idx;
+    return clst;
+}
+
+/* Returns cluster N of CHAIN, counting from 0, or 0 if the chain
+ * is shorter than that. */
+cluster_t fat_chain_nth(struct fat_chain *chain, size_t n) {
+    size_t idx;
+    cluster_t clst;
+
+    if (chain->start == 0)
+        return 0;
+    if (chain->tail != 0 && n >= chain->length)
+        return 0;
+    clst = chain_walk(chain, n, &idx);
+    return idx == n ? clst : 0;
+}
+
+/* Adds a cluster to the end of CHAIN, starting the chain if it is
+ * empty, and returns it, or 0 if the disk is full.  Only the first
+ * append to a chain whose end is not known yet walks it. */
+cluster_t fat_chain_append(struct fat_chain *chain) {
+    cluster_t clst;
+
+    if (chain->start != 0 && chain->tail == 0) {
+        size_t idx;
+        chain->tail = chain_walk(chain, (size_t)-1, &idx);
+        chain->length = idx + 1;
+    }
+
+    clst = fat_create_chain(chain->tail);
+    if (clst == 0)
+        return 0;
+    if (chain->start == 0) {
+        chain->start = clst;
+        chain->pos = 0;
+        chain->pos_clst = clst;
+    }
+    chain_mark(chain, chain->length, clst);
+    chain->tail = clst;
+    chain->length++;
+    return clst;
+}
+
+/* Frees every cluster of CHAIN and leaves it empty. */
+void fat_chain_release(struct fat_chain *chain) {
+    if (chain->start != 0)
+        fat_remove_chain(chain->start, 0);
+    fat_chain_destroy(chain);
 }
@@ -2,9 +2,16 @@
 
 #include <debug.h>
 
+#include "devices/disk.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
 
+/* Readahead window bounds, in sectors.  The window starts at
+ * RA_MIN_SECTORS on the first sequential read and doubles on each
+ * further one up to RA_MAX_SECTORS. */
+#define RA_MIN_SECTORS 4
+#define RA_MAX_SECTORS 32
+
 /* Opens a file for the given INODE, of which it takes ownership,
  * and returns the new file.  Returns a null pointer if an
  * allocation fails or if INODE is null. */
@@ -14,6 +21,8 @@ struct file *file_open(struct inode *inode) {
         file->inode = inode;
         file->pos = 0;
         file->deny_write = false;
+        file->ra_next = 0;
+        file->ra_window = 0;
         return file;
     } else {
         inode_close(inode);
@@ -54,6 +63,24 @@ struct inode *file_get_inode(struct file *file) {
     return file->inode;
 }
 
+/* Updates FILE's readahead state after a read of BYTES_READ bytes
+ * at offset POS.  A read that starts where the previous one ended
+ * grows the window and prefetches the sectors that follow it; any
+ * other read collapses the window. */
+static void file_readahead(struct file *file, off_t pos, off_t bytes_read) {
+    if (bytes_read <= 0)
+        return;
+
+    if (pos == file->ra_next) {
+        file->ra_window = file->ra_window == 0 ? RA_MIN_SECTORS : file->ra_window * 2;
+        if (file->ra_window > RA_MAX_SECTORS)
+            file->ra_window = RA_MAX_SECTORS;
+        inode_readahead(file->inode, pos + bytes_read, file->ra_window * DISK_SECTOR_SIZE);
+    } else
+        file->ra_window = 0;
+    file->ra_next = pos + bytes_read;
+}
+
 /* Reads SIZE bytes from FILE into BUFFER,
  * starting at the file's current position.
  * Returns the number of bytes actually read,
@@ -61,6 +88,7 @@ struct inode *file_get_inode(struct file *file) {
  * Advances FILE's position by the number of bytes read. */
 off_t file_read(struct file *file, void *buffer, off_t size) {
     off_t bytes_read = inode_read_at(file->inode, buffer, size, file->pos);
+    file_readahead(file, file->pos, bytes_read);
     file->pos += bytes_read;
     return bytes_read;
 }
@@ -71,15 +99,16 @@ off_t file_read(struct file *file, void *buffer, off_t size) {
  * which may be less than SIZE if end of file is reached.
  * The file's current position is unaffected. */
 off_t file_read_at(struct file *file, void *buffer, off_t size, off_t file_ofs) {
-    return inode_read_at(file->inode, buffer, size, file_ofs);
+    off_t bytes_read = inode_read_at(file->inode, buffer, size, file_ofs);
+    file_readahead(file, file_ofs, bytes_read);
+    return bytes_read;
 }
 
 /* Writes SIZE bytes from BUFFER into FILE,
  * starting at the file's current position.
  * Returns the number of bytes actually written,
- * which may be less than SIZE if end of file is reached.
- * (Normally we'd grow the file in that case, but file growth is
- * not yet implemented.)
+ * which may be less than SIZE if the disk is full.
+ * Writing past end of file grows the file.
  * Advances FILE's position by the number of bytes read. */
 off_t file_write(struct file *file, const void *buffer, off_t size) {
     off_t bytes_written = inode_write_at(file->inode, buffer, size, file->pos);
@@ -90,9 +119,8 @@ off_t file_write(struct file *file, const void *buffer, off_t size) {
 /* Writes SIZE bytes from BUFFER into FILE,
  * starting at offset FILE_OFS in the file.
  * Returns the number of bytes actually written,
- * which may be less than SIZE if end of file is reached.
- * (Normally we'd grow the file in that case, but file growth is
- * not yet implemented.)
+ * which may be less than SIZE if the disk is full.
+ * Writing past end of file grows the file.
  * The file's current position is unaffected. */
 off_t file_write_at(struct file *file, const void *buffer, off_t size, off_t file_ofs) {
     return inode_write_at(file->inode, buffer, size, file_ofs);
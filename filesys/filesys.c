@@ -5,16 +5,42 @@
 #include <string.h>
 
 #include "devices/disk.h"
+#include "filesys/dcache.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
+#include "filesys/page_cache.h"
 
 /* The disk that contains the file system. */
 struct disk *filesys_disk;
 
 static void do_format(void);
 
+/* Allocates a sector for a new inode and stores it in *SECTORP.
+ * With the FAT, the inode gets a cluster of its own. */
+static bool alloc_inode_sector(disk_sector_t *sectorp) {
+#ifdef EFILESYS
+    cluster_t clst = fat_create_chain(0);
+    if (clst == 0)
+        return false;
+    *sectorp = cluster_to_sector(clst);
+    return true;
+#else
+    return free_map_allocate(1, sectorp);
+#endif
+}
+
+/* Frees an inode sector from alloc_inode_sector(). */
+static void release_inode_sector(disk_sector_t sector) {
+#ifdef EFILESYS
+    fat_remove_chain(sector_to_cluster(sector), 0);
+#else
+    free_map_release(sector, 1);
+#endif
+}
+
 /* Initializes the file system module.
  * If FORMAT is true, reformats the file system. */
 void filesys_init(bool format) {
@@ -23,6 +49,8 @@ void filesys_init(bool format) {
         PANIC("hd0:1 (hdb) not present, file system initialization failed");
 
     inode_init();
+    dcache_init();
+    page_cache_init();
 
 #ifdef EFILESYS
     fat_init();
@@ -38,6 +66,7 @@ void filesys_init(bool format) {
     if (format)
         do_format();
 
+    journal_open();
     free_map_open();
 #endif
 }
@@ -50,7 +79,9 @@ void filesys_done(void) {
     fat_close();
 #else
     free_map_close();
+    journal_close();
 #endif
+    page_cache_flush();
 }
 
 /* Creates a file named NAME with the given INITIAL_SIZE.
@@ -59,12 +90,33 @@ void filesys_done(void) {
  * or if internal memory allocation fails. */
 bool filesys_create(const char *name, off_t initial_size) {
     disk_sector_t inode_sector = 0;
+    journal_begin();
     struct dir *dir = dir_open_root();
-    bool success = (dir != NULL && free_map_allocate(1, &inode_sector) &&
-                    inode_create(inode_sector, initial_size) && dir_add(dir, name, inode_sector));
+    bool success = (dir != NULL && alloc_inode_sector(&inode_sector) &&
+                    inode_create(inode_sector, initial_size, false) &&
+                    dir_add(dir, name, inode_sector, false));
     if (!success && inode_sector != 0)
-        free_map_release(inode_sector, 1);
+        release_inode_sector(inode_sector);
     dir_close(dir);
+    journal_end();
+
+    return success;
+}
+
+/* Creates an empty directory named NAME in the root directory.
+ * Returns true if successful, false otherwise.
+ * Fails if a file named NAME already exists,
+ * or if internal memory allocation fails. */
+bool filesys_mkdir(const char *name) {
+    disk_sector_t inode_sector = 0;
+    journal_begin();
+    struct dir *dir = dir_open_root();
+    bool success = (dir != NULL && alloc_inode_sector(&inode_sector) &&
+                    dir_create(inode_sector, 16) && dir_add(dir, name, inode_sector, true));
+    if (!success && inode_sector != 0)
+        release_inode_sector(inode_sector);
+    dir_close(dir);
+    journal_end();
 
     return success;
 }
@@ -72,7 +124,7 @@ bool filesys_create(const char *name, off_t initial_size) {
 /* Opens the file with the given NAME.
  * Returns the new file if successful or a null pointer
  * otherwise.
- * Fails if no file named NAME exists,
+ * Fails if no file named NAME exists, if NAME is a directory,
  * or if an internal memory allocation fails. */
 struct file *filesys_open(const char *name) {
     struct dir *dir = dir_open_root();
@@ -82,21 +134,92 @@ struct file *filesys_open(const char *name) {
         dir_lookup(dir, name, &inode);
     dir_close(dir);
 
+    if (inode != NULL && inode_is_dir(inode)) {
+        inode_close(inode);
+        inode = NULL;
+    }
     return file_open(inode);
 }
 
-/* Deletes the file named NAME.
+/* Opens the directory with the given NAME, which is either "/"
+ * for the root directory or the name of a directory in it.
+ * Returns the new directory if successful or a null pointer
+ * otherwise. */
+struct dir *filesys_open_dir(const char *name) {
+    struct dir *dir;
+    struct inode *inode = NULL;
+
+    if (!strcmp(name, "/"))
+        return dir_open_root();
+
+    dir = dir_open_root();
+    if (dir != NULL)
+        dir_lookup(dir, name, &inode);
+    dir_close(dir);
+
+    if (inode != NULL && !inode_is_dir(inode)) {
+        inode_close(inode);
+        inode = NULL;
+    }
+    return dir_open(inode);
+}
+
+/* Returns true if NAME in DIR is a directory with entries in it,
+ * which must not be removed. */
+static bool is_busy_dir(struct dir *dir, const char *name) {
+    struct inode *inode = NULL;
+    char entry[NAME_MAX + 1];
+    bool busy = false;
+
+    if (dir_lookup(dir, name, &inode) && inode_is_dir(inode)) {
+        struct dir *sub = dir_open(inode);
+        busy = sub != NULL && dir_readdir(sub, entry);
+        dir_close(sub);
+        return busy;
+    }
+    inode_close(inode);
+    return false;
+}
+
+/* Deletes the file or empty directory named NAME.
  * Returns true if successful, false on failure.
- * Fails if no file named NAME exists,
- * or if an internal memory allocation fails. */
+ * Fails if no file named NAME exists, if NAME is a directory
+ * that is not empty, or if an internal memory allocation fails. */
 bool filesys_remove(const char *name) {
+    journal_begin();
     struct dir *dir = dir_open_root();
-    bool success = dir != NULL && dir_remove(dir, name);
+    bool success = dir != NULL && !is_busy_dir(dir, name) && dir_remove(dir, name);
     dir_close(dir);
+    journal_end();
 
     return success;
 }
 
+/* Makes everything written to the file open as INODE durable.
+ * Its data goes to disk first, then the allocation map and the
+ * journal, and the inode last, so that a crash in between never
+ * leaves the inode covering sectors that were not written. */
+void filesys_fsync(struct inode *inode) {
+    inode_flush_data(inode);
+#ifdef EFILESYS
+    fat_flush();
+#else
+    free_map_flush();
+#endif
+    journal_commit();
+    inode_flush(inode);
+}
+
+/* Makes everything written so far durable: commits the journal,
+ * then writes every dirty cached sector back. */
+void filesys_sync(void) {
+    journal_commit();
+    page_cache_flush();
+#ifdef EFILESYS
+    fat_flush();
+#endif
+}
+
 /* Formats the file system. */
 static void do_format(void) {
     printf("Formatting file system...");
@@ -104,9 +227,12 @@ static void do_format(void) {
 #ifdef EFILESYS
     /* Create FAT and save it to the disk. */
     fat_create();
+    if (!dir_create(ROOT_DIR_SECTOR, 16))
+        PANIC("root directory creation failed");
     fat_close();
 #else
     free_map_create();
+    journal_create();
     if (!dir_create(ROOT_DIR_SECTOR, 16))
         PANIC("root directory creation failed");
     free_map_close();
@@ -2,43 +2,197 @@
 
 #include <bitmap.h>
 #include <debug.h>
+#include <round.h>
 
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/* Sectors tracked by one region: as many as one sector of the free
+ * map file describes. */
+#define REGION_SECTORS (DISK_SECTOR_SIZE * 8)
 
 static struct file *free_map_file; /* Free map file. */
 static struct bitmap *free_map;    /* Free map, one bit per disk sector. */
 
+/* Free sectors in each REGION_SECTORS-sized region, so that full
+ * regions are skipped without scanning their bits. */
+static size_t *region_free;
+static size_t region_cnt;
+
+/* Where the next allocation without a goal starts looking. */
+static disk_sector_t next_hint;
+
+/* Serializes all free map operations. */
+static struct lock free_map_lock;
+
+/* Recomputes every region's free count from the bitmap. */
+static void count_regions(void) {
+    size_t r;
+
+    for (r = 0; r < region_cnt; r++) {
+        size_t start = r * REGION_SECTORS;
+        size_t cnt = bitmap_size(free_map) - start;
+        if (cnt > REGION_SECTORS)
+            cnt = REGION_SECTORS;
+        region_free[r] = bitmap_count(free_map, start, cnt, false);
+    }
+}
+
+/* Sets CNT sectors starting at SECTOR to ALLOCATED, keeping the
+ * region counts in step, and writes just the changed part of the
+ * bitmap to the free map file once it exists.  The bits must all
+ * currently have the opposite value.  Returns false and restores
+ * the bits if the write fails. */
+static bool mark_sectors(disk_sector_t sector, size_t cnt, bool allocated) {
+    size_t i;
+
+    bitmap_set_multiple(free_map, sector, cnt, allocated);
+    for (i = sector; i < sector + cnt; i++) {
+        if (allocated)
+            region_free[i / REGION_SECTORS]--;
+        else
+            region_free[i / REGION_SECTORS]++;
+    }
+
+    if (free_map_file != NULL && !bitmap_write_range(free_map, free_map_file, sector, cnt)) {
+        bitmap_set_multiple(free_map, sector, cnt, !allocated);
+        for (i = sector; i < sector + cnt; i++) {
+            if (allocated)
+                region_free[i / REGION_SECTORS]++;
+            else
+                region_free[i / REGION_SECTORS]--;
+        }
+        return false;
+    }
+    return true;
+}
+
+/* Returns the first run of CNT free sectors that starts in
+ * [START, END), or BITMAP_ERROR. */
+static size_t scan_range(size_t start, size_t end, size_t cnt) {
+    size_t size = bitmap_size(free_map);
+    size_t i;
+
+    for (i = start; i < end && i + cnt <= size; i++)
+        if (!bitmap_test(free_map, i) && bitmap_none(free_map, i, cnt))
+            return i;
+    return BITMAP_ERROR;
+}
+
+/* Finds CNT consecutive free sectors, trying GOAL first, then the
+ * rest of the disk in increasing order, wrapping around to the
+ * sectors before GOAL.  Regions without free sectors are skipped.
+ * Returns the first sector or BITMAP_ERROR. */
+static size_t find_free(disk_sector_t goal, size_t cnt) {
+    size_t first_region, k;
+
+    if (goal >= bitmap_size(free_map))
+        goal = 0;
+    first_region = goal / REGION_SECTORS;
+
+    for (k = 0; k <= region_cnt; k++) {
+        size_t r = (first_region + k) % region_cnt;
+        size_t start = r * REGION_SECTORS;
+        size_t end = start + REGION_SECTORS;
+        size_t sector;
+
+        /* The goal's region is visited twice: from the goal onward
+         * first, and from its start up to the goal last. */
+        if (k == 0)
+            start = goal;
+        else if (k == region_cnt)
+            end = goal;
+        if (region_free[r] == 0 || start >= end)
+            continue;
+
+        sector = scan_range(start, end, cnt);
+        if (sector != BITMAP_ERROR)
+            return sector;
+    }
+    return BITMAP_ERROR;
+}
+
 /* Initializes the free map. */
 void free_map_init(void) {
     free_map = bitmap_create(disk_size(filesys_disk));
     if (free_map == NULL)
         PANIC("bitmap creation failed--disk is too large");
+    region_cnt = DIV_ROUND_UP(bitmap_size(free_map), REGION_SECTORS);
+    region_free = calloc(region_cnt, sizeof *region_free);
+    if (region_free == NULL)
+        PANIC("free map region table creation failed");
+    lock_init(&free_map_lock);
+    lock_register(&free_map_lock, "free map");
+    next_hint = 0;
+
     bitmap_mark(free_map, FREE_MAP_SECTOR);
     bitmap_mark(free_map, ROOT_DIR_SECTOR);
+    bitmap_mark(free_map, JOURNAL_SECTOR);
+    count_regions();
 }
 
 /* Allocates CNT consecutive sectors from the free map and stores
  * the first into *SECTORP.
+ * Allocation is next-fit: the search starts where the previous
+ * one ended.
  * Returns true if successful, false if all sectors were
  * available. */
 bool free_map_allocate(size_t cnt, disk_sector_t *sectorp) {
-    disk_sector_t sector = bitmap_scan_and_flip(free_map, 0, cnt, false);
-    if (sector != BITMAP_ERROR && free_map_file != NULL && !bitmap_write(free_map, free_map_file)) {
-        bitmap_set_multiple(free_map, sector, cnt, false);
+    bool success;
+
+    lock_acquire(&free_map_lock);
+    success = free_map_allocate_near(next_hint, cnt, sectorp);
+    if (success)
+        next_hint = *sectorp + cnt;
+    lock_release(&free_map_lock);
+    return success;
+}
+
+/* Like free_map_allocate(), but looks for the CNT sectors at or
+ * after GOAL first, wrapping to the start of the disk, so that a
+ * growing file stays close to its previous data. */
+bool free_map_allocate_near(disk_sector_t goal, size_t cnt, disk_sector_t *sectorp) {
+    bool held = lock_held_by_current_thread(&free_map_lock);
+    size_t sector;
+
+    if (!held)
+        lock_acquire(&free_map_lock);
+    sector = find_free(goal, cnt);
+    if (sector != BITMAP_ERROR && !mark_sectors(sector, cnt, true))
         sector = BITMAP_ERROR;
-    }
+    if (!held)
+        lock_release(&free_map_lock);
+
     if (sector != BITMAP_ERROR)
         *sectorp = sector;
     return sector != BITMAP_ERROR;
 }
 
+/* Allocates as many of the CNT sectors starting exactly at SECTOR
+ * as are free, stopping at the first one in use.
+ * Returns the number allocated, possibly 0. */
+size_t free_map_extend(disk_sector_t sector, size_t cnt) {
+    size_t got = 0;
+
+    lock_acquire(&free_map_lock);
+    while (got < cnt && sector + got < bitmap_size(free_map) &&
+           !bitmap_test(free_map, sector + got))
+        got++;
+    if (got > 0 && !mark_sectors(sector, got, true))
+        got = 0;
+    lock_release(&free_map_lock);
+    return got;
+}
+
 /* Makes CNT sectors starting at SECTOR available for use. */
 void free_map_release(disk_sector_t sector, size_t cnt) {
+    lock_acquire(&free_map_lock);
     ASSERT(bitmap_all(free_map, sector, cnt));
-    bitmap_set_multiple(free_map, sector, cnt, false);
-    bitmap_write(free_map, free_map_file);
+    mark_sectors(sector, cnt, false);
+    lock_release(&free_map_lock);
 }
 
 /* Opens the free map file and reads it from disk. */
@@ -48,6 +202,7 @@ void free_map_open(void) {
         PANIC("can't open free map");
     if (!bitmap_read(free_map, free_map_file))
         PANIC("can't read free map");
+    count_regions();
 }
 
 /* Writes the free map to disk and closes the free map file. */
@@ -55,11 +210,19 @@ void free_map_close(void) {
     file_close(free_map_file);
 }
 
+/* Writes the cached parts of the free map file back to disk. */
+void free_map_flush(void) {
+    struct inode *inode = file_get_inode(free_map_file);
+
+    inode_flush_data(inode);
+    inode_flush(inode);
+}
+
 /* Creates a new free map file on disk and writes the free map to
  * it. */
 void free_map_create(void) {
     /* Create inode. */
-    if (!inode_create(FREE_MAP_SECTOR, bitmap_file_size(free_map)))
+    if (!inode_create(FREE_MAP_SECTOR, bitmap_file_size(free_map), false))
         PANIC("free map creation failed");
 
     /* Write bitmap to file. */
@@ -1,24 +1,75 @@
 #include "filesys/inode.h"
 
 #include <debug.h>
+#include <hash.h>
 #include <list.h>
 #include <round.h>
 #include <string.h>
 
+#include "filesys/fat.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "filesys/journal.h"
+#include "filesys/page_cache.h"
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* A run of LENGTH consecutive data sectors starting at START.
+ * An unwritten extent is allocated but was never written, so it
+ * reads as zeros without touching the disk. */
+struct extent {
+    disk_sector_t start;     /* First sector. */
+    uint32_t length : 31;    /* Number of sectors. */
+    uint32_t unwritten : 1;  /* Contents are implicitly zero. */
+};
+
+/* Extents stored in the inode itself, and in its overflow block. */
+#define DIRECT_EXTENT_CNT 61
+#define OVERFLOW_EXTENT_CNT (DISK_SECTOR_SIZE / sizeof(struct extent))
+#define MAX_EXTENT_CNT (DIRECT_EXTENT_CNT + OVERFLOW_EXTENT_CNT)
+
+/* Sector pointers in the inode itself and in one index block. */
+#define DIRECT_PTR_CNT 123
+#define PTRS_PER_SECTOR (DISK_SECTOR_SIZE / sizeof(disk_sector_t))
+#define MAX_INDEXED_SECTORS \
+    (DIRECT_PTR_CNT + PTRS_PER_SECTOR + PTRS_PER_SECTOR * PTRS_PER_SECTOR)
+
+/* Layout chosen for inodes created from now on. */
+enum inode_layout inode_default_layout = INODE_EXTENT;
+
 /* On-disk inode.
  * Must be exactly DISK_SECTOR_SIZE bytes long. */
 struct inode_disk {
-    disk_sector_t start;  /* First data sector. */
-    off_t length;         /* File size in bytes. */
-    unsigned magic;       /* Magic number. */
-    uint32_t unused[125]; /* Not used. */
+    off_t length;    /* File size in bytes. */
+    unsigned magic;  /* Magic number. */
+    uint16_t layout; /* enum inode_layout. */
+    uint16_t is_dir; /* Nonzero if the inode holds a directory. */
+    union {
+        /* INODE_EXTENT: data lives in runs of sectors. */
+        struct {
+            uint32_t extent_cnt;                      /* Extents in use. */
+            uint32_t sector_cnt;                      /* Data sectors in all extents. */
+            disk_sector_t overflow;                   /* Overflow extent block, or 0. */
+            struct extent extents[DIRECT_EXTENT_CNT]; /* First extents, in file order. */
+        };
+        /* INODE_INDEXED: one pointer per data sector.  A zero
+         * pointer is a hole that reads as zeros; sector 0 holds the
+         * free map inode, so it is never data. */
+        struct {
+            disk_sector_t direct[DIRECT_PTR_CNT]; /* First data sectors. */
+            disk_sector_t indirect;               /* Block of data pointers. */
+            disk_sector_t doubly_indirect;        /* Block of indirect pointers. */
+        };
+        /* INODE_FAT: data lives in a chain of clusters. */
+        struct {
+            cluster_t start_clst;  /* First data cluster, or 0. */
+            uint32_t cluster_cnt;  /* Clusters in the chain. */
+        };
+    };
 };
 
 /* Returns the number of sectors to allocate for an inode SIZE
@@ -29,41 +80,502 @@ static inline size_t bytes_to_sectors(off_t size) {
 
 /* In-memory inode. */
 struct inode {
-    struct list_elem elem;  /* Element in inode list. */
+    struct hash_elem elem;  /* Element in open_inodes. */
+    struct list_elem lru_elem; /* Element in closed_inodes, if CACHED. */
+    bool cached;            /* Closed, and kept in closed_inodes. */
     disk_sector_t sector;   /* Sector number of disk location. */
     int open_cnt;           /* Number of openers. */
     bool removed;           /* True if deleted, false otherwise. */
     int deny_write_cnt;     /* 0: writes ok, >0: deny writes. */
+    struct lock map_lock;   /* Guards the sector map in DATA. */
+    void *private;          /* Owner's in-memory data, or NULL. */
+    void (*private_destroy)(void *); /* Frees PRIVATE. */
+    struct fat_chain chain; /* Cached view of an INODE_FAT chain. */
     struct inode_disk data; /* Inode content. */
 };
 
+/* Stores the extent with index IDX of DISK_INODE in *EXT. */
+static void extent_get(const struct inode_disk *disk_inode, size_t idx, struct extent *ext) {
+    ASSERT(idx < disk_inode->extent_cnt);
+
+    if (idx < DIRECT_EXTENT_CNT)
+        *ext = disk_inode->extents[idx];
+    else
+        page_cache_read(disk_inode->overflow, ext, (idx - DIRECT_EXTENT_CNT) * sizeof *ext,
+                        sizeof *ext);
+}
+
+/* Stores EXT as the extent with index IDX of DISK_INODE.  IDX may
+ * be one past the last extent, in which case the overflow block
+ * must already exist if it is needed. */
+static void extent_set(struct inode_disk *disk_inode, size_t idx, const struct extent *ext) {
+    ASSERT(idx <= disk_inode->extent_cnt && idx < MAX_EXTENT_CNT);
+
+    if (idx < DIRECT_EXTENT_CNT)
+        disk_inode->extents[idx] = *ext;
+    else
+        page_cache_write(disk_inode->overflow, ext, (idx - DIRECT_EXTENT_CNT) * sizeof *ext,
+                         sizeof *ext);
+}
+
+/* Allocates a sector near GOAL and fills it with zeros in the
+ * buffer cache.  Returns the sector, or 0 if the disk is full. */
+static disk_sector_t alloc_zeroed(disk_sector_t goal) {
+    static char zeros[DISK_SECTOR_SIZE];
+    disk_sector_t sector;
+
+    if (!free_map_allocate_near(goal, 1, &sector))
+        return 0;
+    page_cache_write(sector, zeros, 0, DISK_SECTOR_SIZE);
+    return sector;
+}
+
+/* Returns the pointer in slot IDX of the index block in *BLOCKP.
+ * With ALLOC, first creates the index block if *BLOCKP is 0 and the
+ * target sector if the slot is 0, both zero-filled and near GOAL.
+ * Returns 0 for a hole or when allocation fails. */
+static disk_sector_t index_slot(disk_sector_t *blockp, size_t idx, bool alloc, disk_sector_t goal) {
+    disk_sector_t sector;
+
+    if (*blockp == 0 && (!alloc || (*blockp = alloc_zeroed(goal)) == 0))
+        return 0;
+
+    page_cache_read(*blockp, &sector, idx * sizeof sector, sizeof sector);
+    if (sector == 0 && alloc && (sector = alloc_zeroed(goal)) != 0)
+        page_cache_write(*blockp, &sector, idx * sizeof sector, sizeof sector);
+    return sector;
+}
+
+/* Returns the sector holding data sector IDX of indexed
+ * DISK_INODE, or 0 for a hole.  With ALLOC, fills the hole and any
+ * missing index blocks instead; 0 then means the disk is full. */
+static disk_sector_t indexed_sector(struct inode_disk *disk_inode, size_t idx, bool alloc,
+                                    disk_sector_t goal) {
+    disk_sector_t indirect;
+
+    if (idx < DIRECT_PTR_CNT) {
+        if (disk_inode->direct[idx] == 0 && alloc)
+            disk_inode->direct[idx] = alloc_zeroed(goal);
+        return disk_inode->direct[idx];
+    }
+    idx -= DIRECT_PTR_CNT;
+
+    if (idx < PTRS_PER_SECTOR)
+        return index_slot(&disk_inode->indirect, idx, alloc, goal);
+    idx -= PTRS_PER_SECTOR;
+
+    ASSERT(idx < PTRS_PER_SECTOR * PTRS_PER_SECTOR);
+    indirect = index_slot(&disk_inode->doubly_indirect, idx / PTRS_PER_SECTOR, alloc, goal);
+    if (indirect == 0)
+        return 0;
+    return index_slot(&indirect, idx % PTRS_PER_SECTOR, alloc, goal);
+}
+
+/* Returns the sector holding data sector IDX of DISK_INODE, or 0
+ * if it lies in a hole of an indexed inode or in an unwritten
+ * extent.  IDX must be below the inode's length. */
+static disk_sector_t data_sector(struct inode_disk *disk_inode, size_t idx) {
+    struct extent ext;
+    size_t i;
+
+    if (disk_inode->layout == INODE_INDEXED)
+        return indexed_sector(disk_inode, idx, false, 0);
+
+    for (i = 0; i < disk_inode->extent_cnt; i++) {
+        extent_get(disk_inode, i, &ext);
+        if (idx < ext.length)
+            return ext.unwritten ? 0 : ext.start + idx;
+        idx -= ext.length;
+    }
+    NOT_REACHED();
+}
+
 /* Returns the disk sector that contains byte offset POS within
- * INODE.
+ * INODE, or 0 if POS falls in a hole of an indexed inode or in an
+ * unwritten extent.
  * Returns -1 if INODE does not contain data for a byte at offset
  * POS. */
-static disk_sector_t byte_to_sector(const struct inode *inode, off_t pos) {
+static disk_sector_t byte_to_sector(struct inode *inode, off_t pos) {
+    disk_sector_t sector;
+
     ASSERT(inode != NULL);
-    if (pos < inode->data.length)
-        return inode->data.start + pos / DISK_SECTOR_SIZE;
-    else
+    if (pos >= inode->data.length)
         return -1;
+
+    /* Splitting an extent moves table entries around, and a chain
+     * lookup updates the chain cache, so look up under the lock. */
+    lock_acquire(&inode->map_lock);
+    if (inode->data.layout == INODE_FAT) {
+        size_t idx = pos / DISK_SECTOR_SIZE, spc = fat_cluster_sectors();
+        cluster_t clst = fat_chain_nth(&inode->chain, idx / spc);
+        ASSERT(clst != 0);
+        sector = cluster_to_sector(clst) + idx % spc;
+    } else
+        sector = data_sector(&inode->data, pos / DISK_SECTOR_SIZE);
+    lock_release(&inode->map_lock);
+    return sector;
+}
+
+/* Makes room for DISK_INODE, which lives in sector SELF, to hold
+ * CNT extents, allocating its overflow block if that is needed.
+ * Returns false if CNT extents cannot fit. */
+static bool extent_reserve(struct inode_disk *disk_inode, disk_sector_t self, size_t cnt) {
+    if (cnt > MAX_EXTENT_CNT)
+        return false;
+    if (cnt > DIRECT_EXTENT_CNT && disk_inode->overflow == 0 &&
+        (disk_inode->overflow = alloc_zeroed(self)) == 0)
+        return false;
+    return true;
+}
+
+/* Opens a gap of CNT extents after extent IDX of DISK_INODE, which
+ * lives in sector SELF, by moving the later extents up.  The new
+ * slots hold stale copies until the caller sets them.
+ * Returns false if the extent table is full. */
+static bool extent_insert(struct inode_disk *disk_inode, disk_sector_t self, size_t idx,
+                          size_t cnt) {
+    size_t old_cnt = disk_inode->extent_cnt, j;
+    struct extent ext;
+
+    if (!extent_reserve(disk_inode, self, old_cnt + cnt))
+        return false;
+    disk_inode->extent_cnt += cnt;
+    for (j = old_cnt; j-- > idx + 1;) {
+        extent_get(disk_inode, j, &ext);
+        extent_set(disk_inode, j + cnt, &ext);
+    }
+    return true;
+}
+
+/* Removes extent IDX of DISK_INODE, moving the later extents down. */
+static void extent_remove(struct inode_disk *disk_inode, size_t idx) {
+    struct extent ext;
+    size_t j;
+
+    for (j = idx + 1; j < disk_inode->extent_cnt; j++) {
+        extent_get(disk_inode, j, &ext);
+        extent_set(disk_inode, j - 1, &ext);
+    }
+    disk_inode->extent_cnt--;
+}
+
+/* Converts data sector IDX of extent inode DISK_INODE, which lives
+ * in sector SELF and must lie in an unwritten extent, into a
+ * written sector zero-filled in the buffer cache, and returns it.
+ * A sector that continues the written extent before it just moves
+ * the boundary, so sequential writes keep the table the same size;
+ * otherwise the unwritten extent is split around the sector.  When
+ * the table has no room for the split, the whole extent is zeroed
+ * and marked written instead. */
+static disk_sector_t extent_mark_written(struct inode_disk *disk_inode, disk_sector_t self,
+                                         size_t idx) {
+    static char zeros[DISK_SECTOR_SIZE];
+    struct extent ext, prev, parts[3];
+    size_t i, rel = idx, part_cnt = 0, k;
+    disk_sector_t sector;
+
+    for (i = 0;; i++) {
+        extent_get(disk_inode, i, &ext);
+        if (rel < ext.length)
+            break;
+        rel -= ext.length;
+    }
+    sector = ext.start + rel;
+    if (!ext.unwritten)
+        return sector;
+    page_cache_write(sector, zeros, 0, DISK_SECTOR_SIZE);
+
+    if (rel == 0 && i > 0) {
+        extent_get(disk_inode, i - 1, &prev);
+        if (!prev.unwritten && prev.start + prev.length == ext.start) {
+            prev.length++;
+            extent_set(disk_inode, i - 1, &prev);
+            ext.start++;
+            ext.length--;
+            if (ext.length == 0)
+                extent_remove(disk_inode, i);
+            else
+                extent_set(disk_inode, i, &ext);
+            return sector;
+        }
+    }
+
+    if (rel > 0)
+        parts[part_cnt++] = (struct extent){ext.start, rel, true};
+    parts[part_cnt++] = (struct extent){sector, 1, false};
+    if (rel + 1 < ext.length)
+        parts[part_cnt++] = (struct extent){sector + 1, ext.length - rel - 1, true};
+
+    if (!extent_insert(disk_inode, self, i, part_cnt - 1)) {
+        for (k = 0; k < ext.length; k++)
+            page_cache_write(ext.start + k, zeros, 0, DISK_SECTOR_SIZE);
+        ext.unwritten = false;
+        extent_set(disk_inode, i, &ext);
+        return sector;
+    }
+    for (k = 0; k < part_cnt; k++)
+        extent_set(disk_inode, i + k, &parts[k]);
+    return sector;
+}
+
+/* Appends CNT freshly allocated sectors starting at SECTOR to
+ * DISK_INODE, which lives in sector SELF, as unwritten, merging
+ * them into the last extent when it is unwritten too and they
+ * continue it.  Returns false if the extent table is full. */
+static bool extent_append(struct inode_disk *disk_inode, disk_sector_t self, disk_sector_t sector,
+                          size_t cnt) {
+    struct extent ext;
+    size_t idx = disk_inode->extent_cnt;
+
+    if (idx > 0) {
+        extent_get(disk_inode, idx - 1, &ext);
+        if (ext.unwritten && ext.start + ext.length == sector) {
+            ext.length += cnt;
+            extent_set(disk_inode, idx - 1, &ext);
+            disk_inode->sector_cnt += cnt;
+            return true;
+        }
+    }
+
+    if (!extent_reserve(disk_inode, self, idx + 1))
+        return false;
+    ext.start = sector;
+    ext.length = cnt;
+    ext.unwritten = true;
+    extent_set(disk_inode, idx, &ext);
+    disk_inode->extent_cnt++;
+    disk_inode->sector_cnt += cnt;
+    return true;
+}
+
+/* Grows DISK_INODE, which lives in sector SELF, until its extents
+ * hold at least SECTORS data sectors.  The new sectors are added
+ * as unwritten, so growing costs no data I/O however large.
+ * New space continues the last extent in place when the following
+ * sectors are free, and otherwise comes from the free run nearest
+ * after it, halving the request until a run is found.
+ * Returns false if the disk or the extent table is full; sectors
+ * added before the failure stay allocated. */
+static bool inode_disk_grow(struct inode_disk *disk_inode, disk_sector_t self, size_t sectors) {
+    while (disk_inode->sector_cnt < sectors) {
+        size_t want = sectors - disk_inode->sector_cnt;
+        disk_sector_t goal = self + 1;
+        disk_sector_t start;
+        size_t got = 0;
+
+        if (disk_inode->extent_cnt > 0) {
+            struct extent last;
+            extent_get(disk_inode, disk_inode->extent_cnt - 1, &last);
+            goal = last.start + last.length;
+            got = free_map_extend(goal, want);
+            start = goal;
+        }
+        if (got == 0) {
+            for (got = want; !free_map_allocate_near(goal, got, &start); got /= 2)
+                if (got == 1)
+                    return false;
+        }
+        if (!extent_append(disk_inode, self, start, got)) {
+            free_map_release(start, got);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Appends zero-filled clusters to FAT inode DISK_INODE, whose
+ * chain CHAIN caches, until it holds at least SECTORS sectors.
+ * Returns false if the disk is full; clusters added before the
+ * failure stay in the chain. */
+static bool fat_grow(struct inode_disk *disk_inode, struct fat_chain *chain, size_t sectors) {
+    static char zeros[DISK_SECTOR_SIZE];
+    size_t spc = fat_cluster_sectors();
+
+    while (disk_inode->cluster_cnt * spc < sectors) {
+        cluster_t clst = fat_chain_append(chain);
+        disk_sector_t sector;
+        size_t i;
+
+        if (clst == 0)
+            return false;
+        sector = cluster_to_sector(clst);
+        for (i = 0; i < spc; i++)
+            page_cache_write(sector + i, zeros, 0, DISK_SECTOR_SIZE);
+        disk_inode->start_clst = chain->start;
+        disk_inode->cluster_cnt++;
+    }
+    return true;
+}
+
+/* Calls FUNC on each of the PTR_CNT nonzero pointers in index
+ * block BLOCK, descending LEVELS more levels of index blocks
+ * first, and then on BLOCK itself.  Children are visited before
+ * their index block, so FUNC may free what it is given. */
+static void index_for_each(disk_sector_t block, int levels,
+                           void (*func)(disk_sector_t, size_t)) {
+    disk_sector_t ptrs[PTRS_PER_SECTOR];
+    size_t i;
+
+    if (block == 0)
+        return;
+    page_cache_read(block, ptrs, 0, sizeof ptrs);
+    for (i = 0; i < PTRS_PER_SECTOR; i++)
+        if (ptrs[i] != 0) {
+            if (levels > 0)
+                index_for_each(ptrs[i], levels - 1, func);
+            else
+                func(ptrs[i], 1);
+        }
+    func(block, 1);
+}
+
+/* Calls FUNC on every run of sectors DISK_INODE owns besides its
+ * own: each extent and the overflow block of an extent inode, or
+ * each data and index block of an indexed inode. */
+static void inode_disk_for_each_run(const struct inode_disk *disk_inode,
+                                    void (*func)(disk_sector_t, size_t)) {
+    struct extent ext;
+    size_t i;
+
+    if (disk_inode->layout == INODE_FAT) {
+        cluster_t clst = disk_inode->start_clst;
+        disk_sector_t run = 0;
+        size_t cnt = 0, spc = fat_cluster_sectors();
+
+        /* Merge clusters that happen to be adjacent into one run. */
+        for (i = 0; i < disk_inode->cluster_cnt && clst != 0 && clst != EOChain; i++) {
+            disk_sector_t sector = cluster_to_sector(clst);
+            if (cnt > 0 && sector == run + cnt)
+                cnt += spc;
+            else {
+                if (cnt > 0)
+                    func(run, cnt);
+                run = sector;
+                cnt = spc;
+            }
+            clst = fat_get(clst);
+        }
+        if (cnt > 0)
+            func(run, cnt);
+        return;
+    }
+
+    if (disk_inode->layout == INODE_INDEXED) {
+        for (i = 0; i < DIRECT_PTR_CNT; i++)
+            if (disk_inode->direct[i] != 0)
+                func(disk_inode->direct[i], 1);
+        index_for_each(disk_inode->indirect, 0, func);
+        index_for_each(disk_inode->doubly_indirect, 1, func);
+        return;
+    }
+
+    for (i = 0; i < disk_inode->extent_cnt; i++) {
+        extent_get(disk_inode, i, &ext);
+        func(ext.start, ext.length);
+    }
+    if (disk_inode->overflow != 0)
+        func(disk_inode->overflow, 1);
 }
 
-/* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
-static struct list open_inodes;
+/* Releases every sector DISK_INODE owns besides its own. */
+static void inode_disk_release(const struct inode_disk *disk_inode) {
+    if (disk_inode->layout == INODE_FAT) {
+        if (disk_inode->start_clst != 0)
+            fat_remove_chain(disk_inode->start_clst, 0);
+        return;
+    }
+    inode_disk_for_each_run(disk_inode, free_map_release);
+}
+
+/* Releases the sector holding an inode. */
+static void inode_sector_release(disk_sector_t sector) {
+#ifdef EFILESYS
+    fat_remove_chain(sector_to_cluster(sector), 0);
+#else
+    free_map_release(sector, 1);
+#endif
+}
+
+/* Open inodes by sector, so that opening a single inode twice
+ * returns the same `struct inode'.  Also holds the recently
+ * closed inodes in closed_inodes, with an open_cnt of 0. */
+static struct hash open_inodes;
+
+/* Recently closed inodes, most recent first.  Reopening one of
+ * these reuses its in-memory inode_disk instead of reading the
+ * inode sector again. */
+static struct list closed_inodes;
+static size_t closed_inode_cnt;
+
+/* Most closed inodes kept in closed_inodes. */
+#define CLOSED_INODE_MAX 32
+
+/* Protects open_inodes and closed_inodes.  Lookups share it;
+ * insert/remove take it exclusively. */
+static struct rwlock open_inodes_lock;
+
+static uint64_t inode_hash(const struct hash_elem *e, void *aux UNUSED) {
+    const struct inode *inode = hash_entry(e, struct inode, elem);
+    return hash_int(inode->sector);
+}
+
+static bool inode_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED) {
+    return hash_entry(a, struct inode, elem)->sector < hash_entry(b, struct inode, elem)->sector;
+}
 
 /* Initializes the inode module. */
 void inode_init(void) {
-    list_init(&open_inodes);
+    if (!hash_init(&open_inodes, inode_hash, inode_less, NULL))
+        PANIC("open inode table creation failed");
+    list_init(&closed_inodes);
+    closed_inode_cnt = 0;
+    rwlock_init(&open_inodes_lock);
+    lock_register(&open_inodes_lock.lock, "open inodes");
+}
+
+/* Returns the in-memory inode for SECTOR, open or recently
+ * closed, or a null pointer.
+ * The caller must hold open_inodes_lock in either mode. */
+static struct inode *find_inode(disk_sector_t sector) {
+    struct inode key;
+    struct hash_elem *e;
+
+    key.sector = sector;
+    e = hash_find(&open_inodes, &key.elem);
+    return e != NULL ? hash_entry(e, struct inode, elem) : NULL;
+}
+
+/* Frees INODE and its private data. */
+static void inode_free(struct inode *inode) {
+    if (inode->private != NULL)
+        inode->private_destroy(inode->private);
+    fat_chain_destroy(&inode->chain);
+    free(inode);
+}
+
+/* Keeps INODE, whose last opener is gone, in closed_inodes,
+ * freeing the least recently closed inode if that overflows.
+ * The caller must hold open_inodes_lock for writing. */
+static void cache_closed_inode(struct inode *inode) {
+    ASSERT(inode->open_cnt == 0 && !inode->cached);
+
+    inode->cached = true;
+    list_push_front(&closed_inodes, &inode->lru_elem);
+    if (++closed_inode_cnt > CLOSED_INODE_MAX) {
+        struct inode *victim =
+            list_entry(list_pop_back(&closed_inodes), struct inode, lru_elem);
+        closed_inode_cnt--;
+        hash_delete(&open_inodes, &victim->elem);
+        inode_free(victim);
+    }
 }
 
 /* Initializes an inode with LENGTH bytes of data and
  * writes the new inode to sector SECTOR on the file system
- * disk.
+ * disk.  IS_DIR records whether it will hold a directory.
  * Returns true if successful.
  * Returns false if memory or disk allocation fails. */
-bool inode_create(disk_sector_t sector, off_t length) {
+bool inode_create(disk_sector_t sector, off_t length, bool is_dir) {
     struct inode_disk *disk_inode = NULL;
     bool success = false;
 
@@ -75,20 +587,41 @@ bool inode_create(disk_sector_t sector, off_t length) {
 
     disk_inode = calloc(1, sizeof *disk_inode);
     if (disk_inode != NULL) {
-        size_t sectors = bytes_to_sectors(length);
         disk_inode->length = length;
         disk_inode->magic = INODE_MAGIC;
-        if (free_map_allocate(sectors, &disk_inode->start)) {
-            disk_write(filesys_disk, sector, disk_inode);
-            if (sectors > 0) {
-                static char zeros[DISK_SECTOR_SIZE];
-                size_t i;
-
-                for (i = 0; i < sectors; i++)
-                    disk_write(filesys_disk, disk_inode->start + i, zeros);
-            }
-            success = true;
+        disk_inode->is_dir = is_dir;
+#ifdef EFILESYS
+        /* The other layouts allocate from the free map, which the
+         * FAT file system does not have. */
+        disk_inode->layout = INODE_FAT;
+#else
+        /* The free map file is written by the allocator itself, so
+         * it must never have holes to fill: filling one would
+         * allocate, which writes the free map again.  The system
+         * inodes therefore always use extents. */
+        if (sector == FREE_MAP_SECTOR || sector == ROOT_DIR_SECTOR)
+            disk_inode->layout = INODE_EXTENT;
+        else
+            disk_inode->layout = inode_default_layout;
+#endif
+
+        /* An indexed inode starts out as one big hole; an extent
+         * inode allocates its sectors up front but leaves them
+         * unwritten, so neither writes any data sectors.  A FAT inode
+         * has no way to mark clusters unwritten and zeroes them. */
+        if (disk_inode->layout == INODE_INDEXED)
+            success = bytes_to_sectors(length) <= MAX_INDEXED_SECTORS;
+        else if (disk_inode->layout == INODE_FAT) {
+            struct fat_chain chain;
+            fat_chain_init(&chain, 0);
+            if (!(success = fat_grow(disk_inode, &chain, bytes_to_sectors(length))))
+                inode_disk_release(disk_inode);
+            fat_chain_destroy(&chain);
         }
+        else if (!(success = inode_disk_grow(disk_inode, sector, bytes_to_sectors(length))))
+            inode_disk_release(disk_inode);
+        if (success)
+            page_cache_write(sector, disk_inode, 0, DISK_SECTOR_SIZE);
         free(disk_inode);
     }
     return success;
@@ -98,37 +631,68 @@ bool inode_create(disk_sector_t sector, off_t length) {
  * and returns a `struct inode' that contains it.
  * Returns a null pointer if memory allocation fails. */
 struct inode *inode_open(disk_sector_t sector) {
-    struct list_elem *e;
     struct inode *inode;
 
-    /* Check whether this inode is already open. */
-    for (e = list_begin(&open_inodes); e != list_end(&open_inodes); e = list_next(e)) {
-        inode = list_entry(e, struct inode, elem);
-        if (inode->sector == sector) {
-            inode_reopen(inode);
-            return inode;
+    /* Check whether this inode is already open.  Reviving a closed
+     * one changes closed_inodes, so that waits for the write lock. */
+    rwlock_acquire_read(&open_inodes_lock);
+    inode = find_inode(sector);
+    if (inode != NULL && inode->open_cnt > 0)
+        inode_reopen(inode);
+    else
+        inode = NULL;
+    rwlock_release_read(&open_inodes_lock);
+    if (inode != NULL)
+        return inode;
+
+    rwlock_acquire_write(&open_inodes_lock);
+
+    /* Someone else may have opened it while we were unlocked, or it
+     * may still be in memory since it was last closed. */
+    inode = find_inode(sector);
+    if (inode != NULL) {
+        if (inode->cached) {
+            list_remove(&inode->lru_elem);
+            closed_inode_cnt--;
+            inode->cached = false;
         }
+        inode_reopen(inode);
+        goto done;
     }
 
     /* Allocate memory. */
     inode = malloc(sizeof *inode);
     if (inode == NULL)
-        return NULL;
+        goto done;
 
     /* Initialize. */
-    list_push_front(&open_inodes, &inode->elem);
     inode->sector = sector;
+    hash_insert(&open_inodes, &inode->elem);
+    inode->cached = false;
     inode->open_cnt = 1;
     inode->deny_write_cnt = 0;
     inode->removed = false;
-    disk_read(filesys_disk, inode->sector, &inode->data);
+    lock_init(&inode->map_lock);
+    inode->private = NULL;
+    inode->private_destroy = NULL;
+    page_cache_read(inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+    fat_chain_init(&inode->chain,
+                   inode->data.layout == INODE_FAT ? inode->data.start_clst : 0);
+
+done:
+    rwlock_release_write(&open_inodes_lock);
     return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *inode_reopen(struct inode *inode) {
-    if (inode != NULL)
+    if (inode != NULL) {
+        /* Concurrent lookups in open_inodes may reopen the same
+         * inode, so the increment itself must be atomic. */
+        enum intr_level old_level = intr_disable();
         inode->open_cnt++;
+        intr_set_level(old_level);
+    }
     return inode;
 }
 
@@ -138,26 +702,83 @@ disk_sector_t inode_get_inumber(const struct inode *inode) {
 }
 
 /* Closes INODE and writes it to disk.
- * If this was the last reference to INODE, frees its memory.
- * If INODE was also a removed inode, frees its blocks. */
+ * If this was the last reference to INODE, keeps it among the
+ * recently closed inodes.  If INODE was also a removed inode,
+ * frees its blocks and its memory instead. */
 void inode_close(struct inode *inode) {
     /* Ignore null pointer. */
     if (inode == NULL)
         return;
 
+    /* Push the writes that accumulated in the buffer cache out to
+     * disk if this looks like the last opener.  Done while we still
+     * hold our reference, so the inode cannot be freed under us; a
+     * racing open or close only costs a redundant or skipped flush,
+     * which the write-behind daemon makes up for. */
+    if (inode->open_cnt == 1 && !inode->removed) {
+        inode_flush_data(inode);
+        inode_flush(inode);
+    }
+
     /* Release resources if this was the last opener. */
-    if (--inode->open_cnt == 0) {
-        /* Remove from inode list and release lock. */
-        list_remove(&inode->elem);
-
-        /* Deallocate blocks if removed. */
-        if (inode->removed) {
-            free_map_release(inode->sector, 1);
-            free_map_release(inode->data.start, bytes_to_sectors(inode->data.length));
-        }
+    rwlock_acquire_write(&open_inodes_lock);
+    enum intr_level old_level = intr_disable();
+    bool last = --inode->open_cnt == 0;
+    intr_set_level(old_level);
+    if (last && inode->removed) {
+        /* Remove from inode table, release lock, deallocate. */
+        hash_delete(&open_inodes, &inode->elem);
+        rwlock_release_write(&open_inodes_lock);
+
+        journal_begin();
+        inode_sector_release(inode->sector);
+        inode_disk_release(&inode->data);
+        journal_end();
+        inode_free(inode);
+    } else {
+        if (last)
+            cache_closed_inode(inode);
+        rwlock_release_write(&open_inodes_lock);
+    }
+}
 
-        free(inode);
+/* Writes the cached data sectors of INODE, and its index or
+ * overflow blocks, back to disk. */
+void inode_flush_data(struct inode *inode) {
+    inode_disk_for_each_run(&inode->data, page_cache_flush_range);
+}
+
+/* Writes the cached sector holding INODE itself back to disk. */
+void inode_flush(struct inode *inode) {
+    page_cache_flush_range(inode->sector, 1);
+}
+
+/* Returns true if INODE holds a directory. */
+bool inode_is_dir(const struct inode *inode) {
+    return inode->data.is_dir != 0;
+}
+
+/* Returns the private data attached to INODE, or a null pointer. */
+void *inode_get_private(const struct inode *inode) {
+    return inode->private;
+}
+
+/* Attaches PRIVATE to INODE unless other data is already attached.
+ * DESTROY is called on it when INODE leaves memory, whether it was
+ * removed or just dropped from the recently closed inodes.
+ * Returns the data attached afterward, which is PRIVATE only if
+ * it was installed. */
+void *inode_set_private(struct inode *inode, void *private, void (*destroy)(void *)) {
+    void *cur;
+
+    lock_acquire(&inode->map_lock);
+    if (inode->private == NULL) {
+        inode->private = private;
+        inode->private_destroy = destroy;
     }
+    cur = inode->private;
+    lock_release(&inode->map_lock);
+    return cur;
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -173,7 +794,6 @@ void inode_remove(struct inode *inode) {
 off_t inode_read_at(struct inode *inode, void *buffer_, off_t size, off_t offset) {
     uint8_t *buffer = buffer_;
     off_t bytes_read = 0;
-    uint8_t *bounce = NULL;
 
     while (size > 0) {
         /* Disk sector to read, starting byte offset within sector. */
@@ -190,44 +810,96 @@ off_t inode_read_at(struct inode *inode, void *buffer_, off_t size, off_t offset
         if (chunk_size <= 0)
             break;
 
-        if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-            /* Read full sector directly into caller's buffer. */
-            disk_read(filesys_disk, sector_idx, buffer + bytes_read);
-        } else {
-            /* Read sector into bounce buffer, then partially copy
-             * into caller's buffer. */
-            if (bounce == NULL) {
-                bounce = malloc(DISK_SECTOR_SIZE);
-                if (bounce == NULL)
-                    break;
-            }
-            disk_read(filesys_disk, sector_idx, bounce);
-            memcpy(buffer + bytes_read, bounce + sector_ofs, chunk_size);
-        }
+        /* Copy the chunk out of the buffer cache; holes read as zeros. */
+        if (sector_idx == 0)
+            memset(buffer + bytes_read, 0, chunk_size);
+        else
+            page_cache_read(sector_idx, buffer + bytes_read, sector_ofs, chunk_size);
 
         /* Advance. */
         size -= chunk_size;
         offset += chunk_size;
         bytes_read += chunk_size;
     }
-    free(bounce);
 
     return bytes_read;
 }
 
+/* Asks the buffer cache to load the sectors of INODE covering
+ * LENGTH bytes from OFFSET in the background.  The range is
+ * clipped to the end of the file. */
+void inode_readahead(struct inode *inode, off_t offset, off_t length) {
+    off_t end = offset + length;
+    off_t pos;
+
+    if (end > inode_length(inode))
+        end = inode_length(inode);
+    for (pos = ROUND_DOWN(offset, DISK_SECTOR_SIZE); pos < end; pos += DISK_SECTOR_SIZE) {
+        disk_sector_t sector = byte_to_sector(inode, pos);
+        if (sector != 0)
+            page_cache_prefetch(sector);
+    }
+}
+
+/* Extends INODE to LENGTH bytes, unless it is already that long.
+ * An extent inode allocates the sectors this needs as unwritten;
+ * an indexed inode only moves its end, leaving a hole; a FAT inode
+ * appends zero-filled clusters.
+ * Returns false if space runs out, leaving the length unchanged. */
+static bool inode_extend(struct inode *inode, off_t length) {
+    bool success = true;
+
+    lock_acquire(&inode->map_lock);
+    if (length > inode->data.length) {
+        if (inode->data.layout == INODE_INDEXED)
+            success = bytes_to_sectors(length) <= MAX_INDEXED_SECTORS;
+        else if (inode->data.layout == INODE_FAT)
+            success = fat_grow(&inode->data, &inode->chain, bytes_to_sectors(length));
+        else
+            success = inode_disk_grow(&inode->data, inode->sector, bytes_to_sectors(length));
+        if (success)
+            inode->data.length = length;
+        page_cache_write(inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+    }
+    lock_release(&inode->map_lock);
+    return success;
+}
+
+/* Backs byte POS of INODE, which must read as zeros, with a real
+ * zero-filled sector and returns it: an indexed inode allocates it
+ * near the sector before it, an extent inode marks it written.
+ * Returns 0 if the disk is full. */
+static disk_sector_t inode_fill_hole(struct inode *inode, off_t pos) {
+    size_t idx = pos / DISK_SECTOR_SIZE;
+    disk_sector_t goal = inode->sector, sector;
+
+    lock_acquire(&inode->map_lock);
+    if (inode->data.layout == INODE_EXTENT)
+        sector = extent_mark_written(&inode->data, inode->sector, idx);
+    else {
+        if (idx > 0 && (sector = data_sector(&inode->data, idx - 1)) != 0)
+            goal = sector;
+        sector = indexed_sector(&inode->data, idx, true, goal);
+    }
+    page_cache_write(inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+    lock_release(&inode->map_lock);
+    return sector;
+}
+
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
  * Returns the number of bytes actually written, which may be
- * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
+ * less than SIZE if an error occurs.  A write past end of file
+ * extends the inode first; a gap before OFFSET reads as zeros. */
 off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size, off_t offset) {
     const uint8_t *buffer = buffer_;
     off_t bytes_written = 0;
-    uint8_t *bounce = NULL;
 
     if (inode->deny_write_cnt)
         return 0;
 
+    if (size > 0 && offset + size > inode_length(inode) && !inode_extend(inode, offset + size))
+        return 0;
+
     while (size > 0) {
         /* Sector to write, starting byte offset within sector. */
         disk_sector_t sector_idx = byte_to_sector(inode, offset);
@@ -243,34 +915,20 @@ off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size, off_t
         if (chunk_size <= 0)
             break;
 
-        if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-            /* Write full sector directly to disk. */
-            disk_write(filesys_disk, sector_idx, buffer + bytes_written);
-        } else {
-            /* We need a bounce buffer. */
-            if (bounce == NULL) {
-                bounce = malloc(DISK_SECTOR_SIZE);
-                if (bounce == NULL)
-                    break;
-            }
+        /* Writing into a hole or an unwritten extent backs the
+         * sector first, zero-filled. */
+        if (sector_idx == 0 && (sector_idx = inode_fill_hole(inode, offset)) == 0)
+            break;
 
-            /* If the sector contains data before or after the chunk
-               we're writing, then we need to read in the sector
-               first.  Otherwise we start with a sector of all zeros. */
-            if (sector_ofs > 0 || chunk_size < sector_left)
-                disk_read(filesys_disk, sector_idx, bounce);
-            else
-                memset(bounce, 0, DISK_SECTOR_SIZE);
-            memcpy(bounce + sector_ofs, buffer + bytes_written, chunk_size);
-            disk_write(filesys_disk, sector_idx, bounce);
-        }
+        /* The buffer cache reads the rest of a partially written
+         * sector in itself and writes it back later. */
+        page_cache_write(sector_idx, buffer + bytes_written, sector_ofs, chunk_size);
 
         /* Advance. */
         size -= chunk_size;
         offset += chunk_size;
         bytes_written += chunk_size;
     }
-    free(bounce);
 
     return bytes_written;
 }
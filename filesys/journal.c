@@ -0,0 +1,351 @@
+/* journal.c: Write-ahead log of metadata updates.
+
+   A file system operation bracketed by journal_begin() and
+   journal_end() has the sectors it writes through the buffer cache
+   recorded in the running transaction.  Those sectors stay pinned in
+   the cache, so none of them reaches its home location before the
+   transaction does.  journal_commit() writes the whole transaction to
+   the log as a single run of sectors: a descriptor listing the home
+   sectors, their contents, and a commit block with a checksum.  Once
+   it is there, the pins are dropped and the write-behind daemon
+   writes the sectors back in place whenever it likes.
+
+   Operations are grouped: a transaction is committed by the
+   write-behind daemon, at shutdown, or when it grows too large, not
+   at the end of every operation.  When the log fills up, every dirty
+   sector is written back in place and the log starts over.
+
+   At mount, every complete transaction in the log is copied to its
+   home sectors, so a crash leaves each group of operations either
+   entirely done or entirely undone.
+
+   Journaled operations run one at a time: journal_begin() takes a
+   global lock that journal_end() releases, so every file creation
+   and removal in the system is serialized, including its inode
+   allocation and the freeing of a removed file's blocks.  In
+   exchange, a transaction only ever holds complete operations plus
+   the one in progress.  It can therefore be committed, even in the
+   middle of that operation when it fills up, without waiting for
+   other operations that might be blocked on locks its holder owns.
+   The directory update itself was already serialized by the root
+   directory's index lock, the only directory there is. */
+
+#include "filesys/journal.h"
+
+#include <debug.h>
+#include <hash.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "filesys/filesys.h"
+#include "filesys/free-map.h"
+#include "filesys/page_cache.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Identify the journal's on-disk blocks. */
+#define JOURNAL_MAGIC 0x4a524e4c
+#define DESC_MAGIC 0x4a444553
+#define COMMIT_MAGIC 0x4a434d54
+
+/* Most sectors one transaction holds.  A transaction is committed
+ * before an operation starts if fewer than JOURNAL_TXN_RESERVE of
+ * them are left. */
+#define JOURNAL_TXN_MAX 32
+#define JOURNAL_TXN_RESERVE 16
+
+/* Every sector of the running transaction is pinned in the buffer
+ * cache, and cache_evict() passes pinned entries over.  Unless some
+ * entries are always left unpinned, eviction would never end. */
+#if JOURNAL_TXN_MAX >= PAGE_CACHE_SIZE
+#error "JOURNAL_TXN_MAX must be smaller than PAGE_CACHE_SIZE"
+#endif
+
+/* Sectors one transaction occupies in the log at most. */
+#define TXN_LOG_SECTORS (JOURNAL_TXN_MAX + 2)
+
+/* Journal header, stored at JOURNAL_SECTOR.
+ * Must be exactly DISK_SECTOR_SIZE bytes long. */
+struct journal_header {
+    uint32_t magic;      /* JOURNAL_MAGIC. */
+    disk_sector_t start; /* First sector of the log. */
+    uint32_t size;       /* Sectors in the log. */
+    uint32_t seq;        /* Sequence number of the log's first transaction. */
+    uint8_t unused[DISK_SECTOR_SIZE - 16];
+};
+
+/* First block of a transaction in the log.
+ * Must be exactly DISK_SECTOR_SIZE bytes long. */
+struct journal_desc {
+    uint32_t magic;                         /* DESC_MAGIC. */
+    uint32_t seq;                           /* Transaction sequence number. */
+    uint32_t cnt;                           /* Sectors in the transaction. */
+    disk_sector_t sectors[JOURNAL_TXN_MAX]; /* Home of each logged sector. */
+    uint8_t unused[DISK_SECTOR_SIZE - 12 - JOURNAL_TXN_MAX * sizeof(disk_sector_t)];
+};
+
+/* Last block of a transaction in the log.  A transaction without a
+ * matching commit block was cut short by a crash and is ignored.
+ * Must be exactly DISK_SECTOR_SIZE bytes long. */
+struct journal_commit {
+    uint64_t checksum; /* Hash of the descriptor and the data blocks. */
+    uint32_t magic;    /* COMMIT_MAGIC. */
+    uint32_t seq;      /* Same as the descriptor's. */
+    uint8_t unused[DISK_SECTOR_SIZE - 16];
+};
+
+static bool journal_enabled;          /* Whether the disk has a journal. */
+static struct journal_header header;  /* In-memory copy of the header. */
+static disk_sector_t head;            /* Next free sector, relative to the log. */
+static uint32_t next_seq;             /* Sequence number of the next transaction. */
+
+/* Held by the thread running an operation from journal_begin() to
+ * journal_end(), and while committing. */
+static struct lock journal_lock;
+static int depth; /* Nesting of journal_begin() calls by the holder. */
+
+/* The running transaction: the sectors written since the last
+ * commit. */
+static disk_sector_t txn_sectors[JOURNAL_TXN_MAX];
+static size_t txn_cnt;
+
+/* Assembles a transaction for the log, TXN_LOG_SECTORS long. */
+static uint8_t *log_buf;
+
+static unsigned long long commit_cnt, logged_cnt, split_cnt;
+
+static void commit_locked(void);
+static void checkpoint(void);
+static void replay(void);
+
+/* Returns the address of block I of log_buf. */
+static void *log_block(size_t i) {
+    return log_buf + i * DISK_SECTOR_SIZE;
+}
+
+/* Creates an empty journal on a freshly formatted disk.  Must be
+ * called after the free map is created. */
+void journal_create(void) {
+    static uint8_t zeros[DISK_SECTOR_SIZE];
+    disk_sector_t start;
+
+    if (!free_map_allocate(JOURNAL_SECTORS, &start))
+        PANIC("journal creation failed");
+
+    /* A log left behind by an earlier file system on this disk
+     * must not be mistaken for ours. */
+    disk_write(filesys_disk, start, zeros);
+
+    memset(&header, 0, sizeof header);
+    header.magic = JOURNAL_MAGIC;
+    header.start = start;
+    header.size = JOURNAL_SECTORS;
+    header.seq = 1;
+    disk_write(filesys_disk, JOURNAL_SECTOR, &header);
+}
+
+/* Reads the journal header, replays the transactions a crash left
+ * in the log, and starts journaling.  A disk formatted without a
+ * journal is used without one. */
+void journal_open(void) {
+    ASSERT(sizeof(struct journal_header) == DISK_SECTOR_SIZE);
+    ASSERT(sizeof(struct journal_desc) == DISK_SECTOR_SIZE);
+    ASSERT(sizeof(struct journal_commit) == DISK_SECTOR_SIZE);
+
+    lock_init(&journal_lock);
+    lock_register(&journal_lock, "journal");
+
+    disk_read(filesys_disk, JOURNAL_SECTOR, &header);
+    if (header.magic != JOURNAL_MAGIC || header.size < TXN_LOG_SECTORS)
+        return;
+
+    log_buf = palloc_get_multiple(PAL_ASSERT,
+                                  DIV_ROUND_UP(TXN_LOG_SECTORS * DISK_SECTOR_SIZE, PGSIZE));
+    next_seq = header.seq;
+    replay();
+    checkpoint();
+    journal_enabled = true;
+}
+
+/* Commits the running transaction and empties the log. */
+void journal_close(void) {
+    if (!journal_enabled)
+        return;
+
+    lock_acquire(&journal_lock);
+    commit_locked();
+    checkpoint();
+    lock_release(&journal_lock);
+}
+
+/* Starts an operation whose metadata writes must reach the disk
+ * together.  Nests; only the outermost call takes effect.  Waits
+ * for any other thread's operation to end first: operations are
+ * serialized (see the comment at the top of this file). */
+void journal_begin(void) {
+    if (!journal_enabled)
+        return;
+
+    if (lock_held_by_current_thread(&journal_lock)) {
+        depth++;
+        return;
+    }
+
+    lock_acquire(&journal_lock);
+    if (txn_cnt + JOURNAL_TXN_RESERVE > JOURNAL_TXN_MAX ||
+        head + TXN_LOG_SECTORS > header.size) {
+        commit_locked();
+        if (head + TXN_LOG_SECTORS > header.size)
+            checkpoint();
+    }
+    depth = 1;
+}
+
+/* Ends an operation started with journal_begin().  Its writes are
+ * committed later, together with those of the operations after it. */
+void journal_end(void) {
+    if (!journal_enabled)
+        return;
+
+    ASSERT(lock_held_by_current_thread(&journal_lock));
+    if (--depth == 0)
+        lock_release(&journal_lock);
+}
+
+/* Writes the running transaction to the log. */
+void journal_commit(void) {
+    if (!journal_enabled)
+        return;
+
+    lock_acquire(&journal_lock);
+    commit_locked();
+    lock_release(&journal_lock);
+}
+
+/* Records that SECTOR is being written by the current thread.
+ * Returns true if SECTOR belongs to the running transaction, in
+ * which case the buffer cache must keep it from its home sector
+ * until page_cache_unpin().  Returns false if the current thread is
+ * not inside an operation.
+ *
+ * If the transaction is full, it is committed first and SECTOR
+ * starts a new one.  The operation is then split across two
+ * transactions, but every one of its writes is still logged before
+ * it reaches its home sector.
+ * Called by the buffer cache before it takes its own lock, since a
+ * commit reads through the cache. */
+bool journal_note(disk_sector_t sector) {
+    size_t i;
+
+    if (!journal_enabled || !lock_held_by_current_thread(&journal_lock) || depth == 0)
+        return false;
+
+    for (i = 0; i < txn_cnt; i++)
+        if (txn_sectors[i] == sector)
+            return true;
+    if (txn_cnt == JOURNAL_TXN_MAX) {
+        split_cnt++;
+        commit_locked();
+        if (head + TXN_LOG_SECTORS > header.size)
+            checkpoint();
+    }
+    txn_sectors[txn_cnt++] = sector;
+    return true;
+}
+
+/* Prints journal statistics. */
+void journal_print_stats(void) {
+    if (journal_enabled)
+        printf("Journal: %llu commits, %llu sectors logged, %llu split operations\n",
+               commit_cnt, logged_cnt, split_cnt);
+}
+
+/* Writes the running transaction to the log with one disk write and
+ * releases its sectors to the buffer cache.  Unless journal_note()
+ * is splitting an operation, none is in progress, so the cached
+ * sectors hold exactly what is committed.
+ * journal_begin() or journal_note() has made sure the transaction
+ * fits.
+ * The caller must hold journal_lock. */
+static void commit_locked(void) {
+    struct journal_desc *desc = log_block(0);
+    struct journal_commit *commit = log_block(txn_cnt + 1);
+    size_t i;
+
+    ASSERT(lock_held_by_current_thread(&journal_lock));
+    if (txn_cnt == 0)
+        return;
+    ASSERT(head + txn_cnt + 2 <= header.size);
+
+    memset(desc, 0, sizeof *desc);
+    desc->magic = DESC_MAGIC;
+    desc->seq = next_seq;
+    desc->cnt = txn_cnt;
+    memcpy(desc->sectors, txn_sectors, txn_cnt * sizeof *txn_sectors);
+    for (i = 0; i < txn_cnt; i++)
+        page_cache_read(txn_sectors[i], log_block(i + 1), 0, DISK_SECTOR_SIZE);
+
+    memset(commit, 0, sizeof *commit);
+    commit->checksum = hash_bytes(log_buf, (txn_cnt + 1) * DISK_SECTOR_SIZE);
+    commit->magic = COMMIT_MAGIC;
+    commit->seq = next_seq;
+
+    disk_write_multiple(filesys_disk, header.start + head, log_buf, txn_cnt + 2);
+    head += txn_cnt + 2;
+    next_seq++;
+    commit_cnt++;
+    logged_cnt += txn_cnt;
+
+    page_cache_unpin(txn_sectors, txn_cnt);
+    txn_cnt = 0;
+}
+
+/* Writes every committed sector to its home location and empties
+ * the log.  The running transaction must be empty, or its sectors
+ * would be skipped by the flush while its predecessors in the log
+ * are forgotten. */
+static void checkpoint(void) {
+    ASSERT(txn_cnt == 0);
+
+    page_cache_flush();
+    header.seq = next_seq;
+    disk_write(filesys_disk, JOURNAL_SECTOR, &header);
+    head = 0;
+}
+
+/* Copies every complete transaction in the log to its home
+ * sectors, in order, stopping at the first one that is missing,
+ * stale, or torn.  Advances next_seq past them. */
+static void replay(void) {
+    struct journal_desc *desc = log_block(0);
+    disk_sector_t pos = 0;
+    size_t replayed = 0;
+
+    while (pos + 2 <= header.size) {
+        struct journal_commit *commit;
+        size_t i, n;
+
+        disk_read(filesys_disk, header.start + pos, desc);
+        if (desc->magic != DESC_MAGIC || desc->seq != next_seq || desc->cnt == 0 ||
+            desc->cnt > JOURNAL_TXN_MAX || pos + desc->cnt + 2 > header.size)
+            break;
+
+        n = desc->cnt + 2;
+        disk_read_multiple(filesys_disk, header.start + pos + 1, log_block(1), n - 1);
+        commit = log_block(n - 1);
+        if (commit->magic != COMMIT_MAGIC || commit->seq != next_seq ||
+            commit->checksum != hash_bytes(log_buf, (n - 1) * DISK_SECTOR_SIZE))
+            break;
+
+        for (i = 0; i < desc->cnt; i++)
+            disk_write(filesys_disk, desc->sectors[i], log_block(i + 1));
+        pos += n;
+        next_seq++;
+        replayed++;
+    }
+
+    if (replayed > 0)
+        printf("Journal: replayed %zu transactions.\n", replayed);
+}
@@ -1,9 +1,27 @@
 /* page_cache.c: Implementation of Page Cache (Buffer Cache). */
 
+#include "filesys/page_cache.h"
+
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "devices/timer.h"
+#include "filesys/fat.h"
+#include "filesys/filesys.h"
+#include "filesys/journal.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
 #include "vm/vm.h"
 static bool page_cache_readahead(struct page *page, void *kva);
 static bool page_cache_writeback(struct page *page);
 static void page_cache_destroy(struct page *page);
+static void page_cache_kworkerd(void *aux);
+static void page_cache_readaheadd(void *aux);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations page_cache_op = {
@@ -13,11 +31,297 @@ static const struct page_operations page_cache_op = {
     .type = VM_PAGE_CACHE,
 };
 
+/* Ticks between two passes of the write-behind daemon. */
+#define PAGE_CACHE_FLUSH_TICKS TIMER_FREQ
+
+/* Maximum number of queued readahead requests.  Requests beyond
+ * this are dropped; readahead is only a hint. */
+#define RA_QUEUE_SIZE 64
+
+/* A cached disk sector. */
+struct cache_entry {
+    disk_sector_t sector; /* Cached sector, valid only if VALID. */
+    bool valid;           /* Holds a sector. */
+    bool dirty;           /* Modified since last written back. */
+    bool accessed;        /* Referenced since the clock hand last passed. */
+    bool loading;         /* Being filled by readahead without cache_lock. */
+    bool journaled;       /* In an uncommitted journal transaction; must not be
+                             written back yet. */
+    uint8_t *data;        /* DISK_SECTOR_SIZE bytes of sector data. */
+};
+
+static struct cache_entry cache[PAGE_CACHE_SIZE];
+static size_t clock_hand;
+
+/* Protects every entry and the clock hand.  Held across the disk
+ * I/O that fills or writes back an entry, so a sector is never
+ * observed half-loaded. */
+static struct lock cache_lock;
+
+/* Signaled under cache_lock whenever a readahead fill completes. */
+static struct condition cache_loaded;
+
+/* Ring of sectors waiting for the readahead daemon.  Producers and
+ * the consumer touch it with interrupts off; ra_pending counts the
+ * queued requests. */
+static disk_sector_t ra_queue[RA_QUEUE_SIZE];
+static size_t ra_head, ra_tail;
+static struct semaphore ra_pending;
+
+static unsigned long long cache_hit_cnt, cache_miss_cnt, cache_writeback_cnt, cache_ra_cnt;
+
 tid_t page_cache_workerd;
+tid_t page_cache_readaheadd_tid;
+
+/* The initializer of file vm.  The sector cache itself is set up by
+ * page_cache_init() from filesys_init(), before any VM exists. */
+void pagecache_init(void) {}
+
+/* Initializes the buffer cache and starts its write-behind daemon. */
+void page_cache_init(void) {
+    size_t page_cnt = DIV_ROUND_UP(PAGE_CACHE_SIZE * DISK_SECTOR_SIZE, PGSIZE);
+    uint8_t *data = palloc_get_multiple(PAL_ASSERT, page_cnt);
+    size_t i;
+
+    for (i = 0; i < PAGE_CACHE_SIZE; i++) {
+        cache[i].valid = false;
+        cache[i].dirty = false;
+        cache[i].accessed = false;
+        cache[i].loading = false;
+        cache[i].journaled = false;
+        cache[i].data = data + i * DISK_SECTOR_SIZE;
+    }
+    clock_hand = 0;
+    lock_init(&cache_lock);
+    lock_register(&cache_lock, "page cache");
+    cond_init(&cache_loaded);
+    ra_head = ra_tail = 0;
+    sema_init(&ra_pending, 0);
+
+    page_cache_workerd = thread_create("page_cache_kworkerd", PRI_DEFAULT, page_cache_kworkerd,
+                                       NULL);
+    page_cache_readaheadd_tid = thread_create("page_cache_readaheadd", PRI_DEFAULT,
+                                              page_cache_readaheadd, NULL);
+    if (page_cache_workerd == TID_ERROR || page_cache_readaheadd_tid == TID_ERROR)
+        PANIC("page cache daemon creation failed");
+}
+
+/* Write-back scratch space, one slot per entry.  Protected by
+ * cache_lock. */
+static struct cache_entry *wb_batch[PAGE_CACHE_SIZE];
+static struct disk_request wb_reqs[PAGE_CACHE_SIZE];
+
+/* Writes the N dirty entries in BATCH back to disk.  Every write is
+ * submitted before any is waited on, so the disk dispatcher merges
+ * runs of consecutive sectors into single commands.
+ * The caller must hold cache_lock. */
+static void cache_writeback_batch(struct cache_entry **batch, size_t n) {
+    size_t i;
+
+    ASSERT(lock_held_by_current_thread(&cache_lock));
+
+    for (i = 0; i < n; i++) {
+        struct disk_request *req = &wb_reqs[i];
+
+        ASSERT(batch[i]->valid && batch[i]->dirty);
+        req->disk = filesys_disk;
+        req->sector = batch[i]->sector;
+        req->cnt = 1;
+        req->buffer = batch[i]->data;
+        req->write = true;
+        req->complete = NULL;
+        disk_submit(req);
+    }
+    for (i = 0; i < n; i++) {
+        sema_down(&wb_reqs[i].done);
+        batch[i]->dirty = false;
+        cache_writeback_cnt++;
+    }
+}
+
+/* Returns the entry holding SECTOR, even one still being loaded,
+ * or a null pointer.
+ * The caller must hold cache_lock. */
+static struct cache_entry *cache_find(disk_sector_t sector) {
+    size_t i;
+
+    for (i = 0; i < PAGE_CACHE_SIZE; i++)
+        if (cache[i].valid && cache[i].sector == sector)
+            return &cache[i];
+    return NULL;
+}
+
+/* Returns true if E may be written back to disk now. */
+static bool cache_writable(const struct cache_entry *e) {
+    return e->dirty && !e->journaled;
+}
+
+/* Writes dirty E back to disk together with the dirty entries of
+ * the sectors immediately before and after it, so that a run of
+ * small appends leaves the cache as one multi-sector write.
+ * The caller must hold cache_lock. */
+static void cache_writeback_run(struct cache_entry *e) {
+    struct cache_entry *x;
+    disk_sector_t s;
+    size_t n = 0;
+
+    for (s = e->sector; s > 0 && n < PAGE_CACHE_SIZE / 2; s--) {
+        x = cache_find(s - 1);
+        if (x == NULL || !cache_writable(x))
+            break;
+        wb_batch[n++] = x;
+    }
+    wb_batch[n++] = e;
+    for (s = e->sector + 1; n < PAGE_CACHE_SIZE; s++) {
+        x = cache_find(s);
+        if (x == NULL || !cache_writable(x))
+            break;
+        wb_batch[n++] = x;
+    }
+    cache_writeback_batch(wb_batch, n);
+}
+
+/* Returns the entry caching SECTOR, or a null pointer.  Waits
+ * for a readahead fill of SECTOR in progress to finish first.
+ * The caller must hold cache_lock. */
+static struct cache_entry *cache_lookup(disk_sector_t sector) {
+    struct cache_entry *e;
+
+    while ((e = cache_find(sector)) != NULL && e->loading)
+        cond_wait(&cache_loaded, &cache_lock);
+    return e;
+}
+
+/* Chooses an entry to reuse with the clock algorithm, writing it
+ * back first if it is dirty.  An entry referenced since the hand
+ * last passed gets a second chance; one pinned by the journal is
+ * passed over.  The journal pins fewer than PAGE_CACHE_SIZE entries
+ * (journal.c checks this at compile time) and readahead fills are
+ * bounded, so the hand always finds a victim. */
+static struct cache_entry *cache_evict(void) {
+    for (;;) {
+        struct cache_entry *e = &cache[clock_hand];
+        clock_hand = (clock_hand + 1) % PAGE_CACHE_SIZE;
+
+        if (!e->valid)
+            return e;
+        if (e->loading || e->journaled)
+            continue;
+        if (e->accessed) {
+            e->accessed = false;
+            continue;
+        }
+        if (e->dirty)
+            cache_writeback_run(e);
+        e->valid = false;
+        return e;
+    }
+}
+
+/* Returns the entry for SECTOR, loading it on a miss.  If FILL is
+ * false the caller is about to overwrite the whole sector, so the
+ * disk read is skipped.
+ * The caller must hold cache_lock. */
+static struct cache_entry *cache_get(disk_sector_t sector, bool fill) {
+    struct cache_entry *e = cache_lookup(sector);
+
+    if (e != NULL) {
+        cache_hit_cnt++;
+    } else {
+        cache_miss_cnt++;
+        e = cache_evict();
+        if (fill)
+            disk_read(filesys_disk, sector, e->data);
+        e->sector = sector;
+        e->valid = true;
+        e->dirty = false;
+        e->journaled = false;
+    }
+    e->accessed = true;
+    return e;
+}
+
+/* Copies SIZE bytes starting at byte OFS of SECTOR into BUFFER. */
+void page_cache_read(disk_sector_t sector, void *buffer, size_t ofs, size_t size) {
+    ASSERT(ofs + size <= DISK_SECTOR_SIZE);
+
+    lock_acquire(&cache_lock);
+    struct cache_entry *e = cache_get(sector, true);
+    memcpy(buffer, e->data + ofs, size);
+    lock_release(&cache_lock);
+}
+
+/* Copies SIZE bytes from BUFFER into SECTOR starting at byte OFS.
+ * The sector reaches the disk on eviction, on the next pass of the
+ * daemon, or at page_cache_flush().  Inside a journaled operation,
+ * not before the operation's transaction is committed. */
+void page_cache_write(disk_sector_t sector, const void *buffer, size_t ofs, size_t size) {
+    ASSERT(ofs + size <= DISK_SECTOR_SIZE);
+
+    bool journaled = journal_note(sector);
+
+    lock_acquire(&cache_lock);
+    struct cache_entry *e = cache_get(sector, size < DISK_SECTOR_SIZE);
+    memcpy(e->data + ofs, buffer, size);
+    e->dirty = true;
+    if (journaled)
+        e->journaled = true;
+    lock_release(&cache_lock);
+}
+
+/* Queues SECTOR to be loaded into the cache in the background.
+ * Returns immediately; the request is dropped if the queue is
+ * full. */
+void page_cache_prefetch(disk_sector_t sector) {
+    enum intr_level old_level = intr_disable();
+    size_t next = (ra_head + 1) % RA_QUEUE_SIZE;
+
+    if (next != ra_tail) {
+        ra_queue[ra_head] = sector;
+        ra_head = next;
+        sema_up(&ra_pending);
+    }
+    intr_set_level(old_level);
+}
+
+/* Writes every dirty cached sector in [START, START + CNT) back
+ * to disk, except those the journal has not committed yet. */
+void page_cache_flush_range(disk_sector_t start, size_t cnt) {
+    size_t i, n = 0;
+
+    lock_acquire(&cache_lock);
+    for (i = 0; i < PAGE_CACHE_SIZE; i++) {
+        struct cache_entry *e = &cache[i];
+        if (e->valid && cache_writable(e) && e->sector >= start && e->sector - start < cnt)
+            wb_batch[n++] = e;
+    }
+    cache_writeback_batch(wb_batch, n);
+    lock_release(&cache_lock);
+}
+
+/* Writes every dirty sector back to disk. */
+void page_cache_flush(void) {
+    page_cache_flush_range(0, (disk_sector_t)-1);
+}
+
+/* Lets the CNT SECTORS, just committed by the journal, be written
+ * back like any other dirty sector. */
+void page_cache_unpin(const disk_sector_t *sectors, size_t cnt) {
+    size_t i;
+
+    lock_acquire(&cache_lock);
+    for (i = 0; i < cnt; i++) {
+        struct cache_entry *e = cache_find(sectors[i]);
+        if (e != NULL)
+            e->journaled = false;
+    }
+    lock_release(&cache_lock);
+}
 
-/* The initializer of file vm */
-void pagecache_init(void) {
-    /* TODO: Create a worker daemon for page cache with page_cache_kworkerd */
+/* Prints buffer cache statistics. */
+void page_cache_print_stats(void) {
+    printf("Page cache: %llu hits, %llu misses, %llu writebacks, %llu readaheads\n",
+           cache_hit_cnt, cache_miss_cnt, cache_writeback_cnt, cache_ra_cnt);
 }
 
 /* Initialize the page cache */
@@ -35,5 +339,56 @@ static bool page_cache_writeback(struct page *page) {}
 /* Destory the page_cache. */
 static void page_cache_destroy(struct page *page) {}
 
-/* Worker thread for page cache */
-static void page_cache_kworkerd(void *aux) {}
+/* Worker thread for page cache.  Periodically commits the journal
+ * and writes dirty sectors back, and with the FAT file system the
+ * modified FAT sectors after them, so that a crash loses at most
+ * PAGE_CACHE_FLUSH_TICKS of writes. */
+static void page_cache_kworkerd(void *aux UNUSED) {
+    for (;;) {
+        timer_sleep(PAGE_CACHE_FLUSH_TICKS);
+        journal_commit();
+        page_cache_flush();
+#ifdef EFILESYS
+        fat_flush();
+#endif
+    }
+}
+
+/* Readahead daemon.  Loads queued sectors into the cache.  The
+ * entry is reserved and marked loading under cache_lock, but the
+ * disk read itself runs unlocked so that readers keep copying out
+ * of other cached sectors meanwhile. */
+static void page_cache_readaheadd(void *aux UNUSED) {
+    for (;;) {
+        struct cache_entry *e;
+        disk_sector_t sector;
+
+        sema_down(&ra_pending);
+        enum intr_level old_level = intr_disable();
+        sector = ra_queue[ra_tail];
+        ra_tail = (ra_tail + 1) % RA_QUEUE_SIZE;
+        intr_set_level(old_level);
+
+        lock_acquire(&cache_lock);
+        if (cache_lookup(sector) != NULL) {
+            lock_release(&cache_lock);
+            continue;
+        }
+        e = cache_evict();
+        e->sector = sector;
+        e->valid = true;
+        e->dirty = false;
+        e->journaled = false;
+        e->accessed = true;
+        e->loading = true;
+        lock_release(&cache_lock);
+
+        disk_read(filesys_disk, sector, e->data);
+
+        lock_acquire(&cache_lock);
+        e->loading = false;
+        cache_ra_cnt++;
+        cond_broadcast(&cache_loaded, &cache_lock);
+        lock_release(&cache_lock);
+    }
+}
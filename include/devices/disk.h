@@ -2,8 +2,13 @@
 #define DEVICES_DISK_H
 
 #include <inttypes.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "threads/synch.h"
+
 /* Size of a disk sector in bytes. */
 #define DISK_SECTOR_SIZE 512
 
@@ -15,6 +20,24 @@ typedef uint32_t disk_sector_t;
  * printf ("sector=%"PRDSNu"\n", sector); */
 #define PRDSNu PRIu32
 
+/* An asynchronous transfer of CNT sectors starting at SECTOR.
+ * Filled in by the caller and handed to disk_submit(). */
+struct disk_request {
+    struct disk *disk;
+    disk_sector_t sector;
+    size_t cnt;
+    void *buffer; /* CNT * DISK_SECTOR_SIZE bytes. */
+    bool write;
+
+    /* Called from the channel's dispatcher thread on completion.
+     * If null, DONE is up'd instead. */
+    void (*complete)(struct disk_request *);
+    void *aux; /* For use by COMPLETE. */
+
+    struct semaphore done;  /* Owned by disk.c. */
+    struct list_elem elem;  /* Owned by disk.c. */
+};
+
 void disk_init(void);
 void disk_print_stats(void);
 
@@ -22,6 +45,9 @@ struct disk *disk_get(int chan_no, int dev_no);
 disk_sector_t disk_size(struct disk *);
 void disk_read(struct disk *, disk_sector_t, void *);
 void disk_write(struct disk *, disk_sector_t, const void *);
+void disk_read_multiple(struct disk *, disk_sector_t, void *, size_t cnt);
+void disk_write_multiple(struct disk *, disk_sector_t, const void *, size_t cnt);
+void disk_submit(struct disk_request *);
 
 void register_disk_inspect_intr();
 #endif /* devices/disk.h */
@@ -24,8 +24,15 @@ struct inode *dir_get_inode(struct dir *);
 
 /* Reading and writing. */
 bool dir_lookup(const struct dir *, const char *name, struct inode **);
-bool dir_add(struct dir *, const char *name, disk_sector_t);
+bool dir_add(struct dir *, const char *name, disk_sector_t, bool is_dir);
 bool dir_remove(struct dir *, const char *name);
 bool dir_readdir(struct dir *, char name[NAME_MAX + 1]);
 
+/* Called by dir_readdir_each() for each entry, with the type
+ * recorded in the entry itself.  Returns false to stop without
+ * consuming the entry. */
+typedef bool dir_emit_func(disk_sector_t inode_sector, const char *name, bool is_dir,
+                           void *aux);
+int dir_readdir_each(struct dir *, dir_emit_func *, void *aux);
+
 #endif /* filesys/directory.h */
@@ -15,15 +15,21 @@ typedef uint32_t cluster_t; /* Index of a cluster within FAT. */
 #define EOChain 0x0FFFFFFF   /* End of cluster chain */
 
 /* Sectors of FAT information. */
-#define SECTORS_PER_CLUSTER 1 /* Number of sectors per cluster */
+#define SECTORS_PER_CLUSTER 8 /* Default number of sectors per cluster: one page */
+#define MAX_SECTORS_PER_CLUSTER 64
 #define FAT_BOOT_SECTOR 0     /* FAT boot sector. */
 #define ROOT_DIR_CLUSTER 1    /* Cluster for the root directory */
 
+/* Sectors per cluster of a file system formatted from now on.
+ * A mounted file system uses the size it was formatted with. */
+extern unsigned int fat_format_cluster_sectors;
+
 void fat_init(void);
 void fat_open(void);
 void fat_close(void);
 void fat_create(void);
 void fat_close(void);
+void fat_flush(void);
 
 cluster_t fat_create_chain(cluster_t clst /* Cluster # to stretch, 0: Create a new chain */
 );
@@ -33,5 +39,33 @@ void fat_remove_chain(cluster_t clst, /* Cluster # to be removed */
 cluster_t fat_get(cluster_t clst);
 void fat_put(cluster_t clst, cluster_t val);
 disk_sector_t cluster_to_sector(cluster_t clst);
+cluster_t sector_to_cluster(disk_sector_t sector);
+unsigned int fat_cluster_sectors(void);
+
+/* Every FAT_CHAIN_MARK_GAP'th cluster of a chain is remembered by
+ * its fat_chain, so no lookup walks more links than this. */
+#define FAT_CHAIN_MARK_GAP 16
+
+/* An in-memory handle on a cluster chain that caches what it
+ * learns: its last cluster, so appending takes no walk; the most
+ * recently looked up position, so sequential access takes one link
+ * per cluster; and regularly spaced clusters, so seeking anywhere
+ * walks at most FAT_CHAIN_MARK_GAP links. */
+struct fat_chain {
+    cluster_t start;     /* First cluster, or 0 for an empty chain. */
+    cluster_t tail;      /* Last cluster, or 0 if not known yet. */
+    size_t length;       /* Clusters in the chain, if TAIL is known. */
+    size_t pos;          /* Index of POS_CLST within the chain. */
+    cluster_t pos_clst;  /* Cluster last looked up, or 0. */
+    cluster_t *marks;    /* MARKS[I] is cluster I * FAT_CHAIN_MARK_GAP. */
+    size_t mark_cnt;     /* Entries of MARKS known. */
+    size_t mark_cap;     /* Entries MARKS has room for. */
+};
+
+void fat_chain_init(struct fat_chain *, cluster_t start);
+void fat_chain_destroy(struct fat_chain *);
+cluster_t fat_chain_nth(struct fat_chain *, size_t n);
+cluster_t fat_chain_append(struct fat_chain *);
+void fat_chain_release(struct fat_chain *);
 
 #endif /* filesys/fat.h */
@@ -12,6 +12,8 @@ struct file {
     struct inode *inode; /* File's inode. */
     off_t pos;           /* Current position. */
     bool deny_write;     /* Has file_deny_write() been called? */
+    off_t ra_next;       /* Offset a sequential reader reads next. */
+    off_t ra_window;     /* Readahead window in sectors, 0 if random. */
 };
 
 extern struct file *global_stdin;
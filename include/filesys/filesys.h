@@ -7,7 +7,13 @@
 
 /* Sectors of system file inodes. */
 #define FREE_MAP_SECTOR 0 /* Free map file inode sector. */
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#define ROOT_DIR_SECTOR cluster_to_sector(ROOT_DIR_CLUSTER) /* Root directory inode sector. */
+#else
 #define ROOT_DIR_SECTOR 1 /* Root directory file inode sector. */
+#endif
+#define JOURNAL_SECTOR 2 /* Journal header sector; unused with the FAT. */
 
 /* Disk used for file system. */
 extern struct disk *filesys_disk;
@@ -15,7 +21,13 @@ extern struct disk *filesys_disk;
 void filesys_init(bool format);
 void filesys_done(void);
 bool filesys_create(const char *name, off_t initial_size);
+bool filesys_mkdir(const char *name);
 struct file *filesys_open(const char *name);
+struct dir *filesys_open_dir(const char *name);
 bool filesys_remove(const char *name);
 
+struct inode;
+void filesys_fsync(struct inode *);
+void filesys_sync(void);
+
 #endif /* filesys/filesys.h */
@@ -8,17 +8,33 @@
 
 struct bitmap;
 
+/* On-disk inode formats. */
+enum inode_layout {
+    INODE_EXTENT,  /* Runs of sectors; files are fully allocated. */
+    INODE_INDEXED, /* Direct/indirect/doubly indirect; sparse. */
+    INODE_FAT      /* Chain of FAT clusters; used with EFILESYS. */
+};
+
+/* Layout of newly created inodes.  Existing inodes keep theirs. */
+extern enum inode_layout inode_default_layout;
+
 void inode_init(void);
-bool inode_create(disk_sector_t, off_t);
+bool inode_create(disk_sector_t, off_t, bool is_dir);
 struct inode *inode_open(disk_sector_t);
 struct inode *inode_reopen(struct inode *);
 disk_sector_t inode_get_inumber(const struct inode *);
+bool inode_is_dir(const struct inode *);
 void inode_close(struct inode *);
+void inode_flush_data(struct inode *);
+void inode_flush(struct inode *);
 void inode_remove(struct inode *);
 off_t inode_read_at(struct inode *, void *, off_t size, off_t offset);
+void inode_readahead(struct inode *, off_t offset, off_t length);
 off_t inode_write_at(struct inode *, const void *, off_t size, off_t offset);
 void inode_deny_write(struct inode *);
 void inode_allow_write(struct inode *);
 off_t inode_length(const struct inode *);
+void *inode_get_private(const struct inode *);
+void *inode_set_private(struct inode *, void *, void (*destroy)(void *));
 
 #endif /* filesys/inode.h */
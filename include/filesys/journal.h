@@ -0,0 +1,22 @@
+#ifndef FILESYS_JOURNAL_H
+#define FILESYS_JOURNAL_H
+
+#include <stdbool.h>
+
+#include "devices/disk.h"
+
+/* Sectors in the on-disk log, including its descriptor and commit
+ * blocks. */
+#define JOURNAL_SECTORS 128
+
+void journal_create(void);
+void journal_open(void);
+void journal_close(void);
+
+void journal_begin(void);
+void journal_end(void);
+void journal_commit(void);
+bool journal_note(disk_sector_t sector);
+void journal_print_stats(void);
+
+#endif /* filesys/journal.h */
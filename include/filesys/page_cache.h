@@ -1,12 +1,26 @@
 #ifndef FILESYS_PAGE_CACHE_H
 #define FILESYS_PAGE_CACHE_H
-#include "vm/vm.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "devices/disk.h"
+#include "vm/vm_type.h"
 
 struct page;
-enum vm_type;
 
 struct page_cache {};
 
+/* Number of sectors held by the buffer cache. */
+#define PAGE_CACHE_SIZE 64
+
 void page_cache_init(void);
 bool page_cache_initializer(struct page *page, enum vm_type type, void *kva);
+
+void page_cache_read(disk_sector_t sector, void *buffer, size_t ofs, size_t size);
+void page_cache_write(disk_sector_t sector, const void *buffer, size_t ofs, size_t size);
+void page_cache_prefetch(disk_sector_t sector);
+void page_cache_flush_range(disk_sector_t start, size_t cnt);
+void page_cache_flush(void);
+void page_cache_unpin(const disk_sector_t *sectors, size_t cnt);
+void page_cache_print_stats(void);
 #endif
@@ -36,6 +36,17 @@ enum {
 
     SYS_MOUNT,
     SYS_UMOUNT,
+
+    /* Extra for Project 4 */
+    SYS_GETDENTS,        /* Reads many directory entries at once. */
+    SYS_FSYNC,           /* Writes a file's cached data to disk. */
+    SYS_SYNC,            /* Writes all cached data to disk. */
+    SYS_PREAD,           /* Reads from a given file offset. */
+    SYS_PWRITE,          /* Writes at a given file offset. */
+    SYS_READV,           /* Reads into several buffers. */
+    SYS_WRITEV,          /* Writes from several buffers. */
+    SYS_COPY_FILE_RANGE, /* Copies between files inside the kernel. */
+    SYS_SENDFILE,        /* Copies a file to a file or the console. */
 };
 
 #endif /* lib/syscall-nr.h */
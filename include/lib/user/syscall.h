@@ -16,6 +16,28 @@ typedef int off_t;
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* A directory entry record written by getdents().  Records are
+ * packed back to back; D_RECLEN gives the distance to the next. */
+struct dirent {
+    int d_ino;               /* Inode number. */
+    unsigned short d_reclen; /* Length of this record in bytes. */
+    unsigned char d_type;    /* DT_REG or DT_DIR. */
+    char d_name[];           /* Null-terminated file name. */
+};
+
+/* Values of d_type. */
+#define DT_REG 1 /* Regular file. */
+#define DT_DIR 2 /* Directory. */
+
+/* One buffer of a readv() or writev() call. */
+struct iovec {
+    void *iov_base; /* Start of the buffer. */
+    size_t iov_len; /* Size of the buffer in bytes. */
+};
+
+/* Most buffers one readv() or writev() call accepts. */
+#define IOV_MAX 64
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0 /* Successful execution. */
 #define EXIT_FAILURE 1 /* Unsuccessful execution. */
@@ -35,6 +57,12 @@ int write(int fd, const void *buffer, unsigned length);
 void seek(int fd, unsigned position);
 unsigned tell(int fd);
 void close(int fd);
+int pread(int fd, void *buffer, unsigned length, off_t offset);
+int pwrite(int fd, const void *buffer, unsigned length, off_t offset);
+int readv(int fd, const struct iovec *iov, int iovcnt);
+int writev(int fd, const struct iovec *iov, int iovcnt);
+int copy_file_range(int fd_in, int fd_out, unsigned length);
+int sendfile(int out_fd, int in_fd, unsigned length);
 
 int dup2(int oldfd, int newfd);
 
@@ -49,6 +77,9 @@ bool readdir(int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir(int fd);
 int inumber(int fd);
 int symlink(const char *target, const char *linkpath);
+int getdents(int fd, void *buffer, unsigned size);
+int fsync(int fd);
+void sync(void);
 
 static inline void *get_phys_addr(void *user_addr) {
     void *pa;
@@ -16,10 +16,22 @@ bool sema_try_down(struct semaphore *);
 void sema_up(struct semaphore *);
 void sema_self_test(void);
 
+/* Contention statistics kept for every lock.  Only locks passed
+ * to lock_register() are reported by lock_print_stats(). */
+struct lock_stats {
+    const char *name;                  /* Name given to lock_register(), or NULL. */
+    unsigned long long acquire_cnt;    /* # of successful acquires. */
+    unsigned long long contended_cnt;  /* # of acquires that had to sleep. */
+    long long wait_ticks;              /* Total timer ticks spent sleeping. */
+    long long max_hold_ticks;          /* Longest time held, in timer ticks. */
+    long long acquired_at;             /* Tick of the current acquisition. */
+};
+
 /* Lock. */
 struct lock {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+    struct lock_stats stats;    /* Contention statistics. */
 };
 
 void lock_init(struct lock *);
@@ -27,9 +39,11 @@ void lock_acquire(struct lock *);
 bool lock_try_acquire(struct lock *);
 void lock_release(struct lock *);
 bool lock_held_by_current_thread(const struct lock *);
+void lock_register(struct lock *, const char *name);
+void lock_print_stats(void);
 
-struct thread *find_same_priority_in_donor_list(struct thread *holder,
-                                                struct thread *donor);  //	$우선순위 기부
+/* 우선순위 기부가 wait_on_lock 체인을 따라 전파되는 최대 깊이. */
+#define DONATION_DEPTH_MAX 8
 
 /* Condition variable. */
 struct condition {
@@ -41,6 +55,23 @@ void cond_wait(struct condition *, struct lock *);
 void cond_signal(struct condition *, struct lock *);
 void cond_broadcast(struct condition *, struct lock *);
 
+/* Reader-writer lock.
+ * 여러 reader가 동시에 보유하거나 writer 하나가 배타적으로 보유한다.
+ * writer는 내부 LOCK을 보유한 채로 임계 구역을 실행하므로, 뒤따르는 reader와
+ * writer는 그 LOCK에서 대기하며 기존 우선순위 기부를 그대로 받는다. */
+struct rwlock {
+    struct lock lock;         /* Held by the writer; readers take it briefly. */
+    struct semaphore drained; /* Up'd when the last reader leaves. */
+    unsigned readers;         /* Number of threads holding shared access. */
+};
+
+void rwlock_init(struct rwlock *);
+void rwlock_acquire_read(struct rwlock *);
+void rwlock_release_read(struct rwlock *);
+void rwlock_acquire_write(struct rwlock *);
+void rwlock_release_write(struct rwlock *);
+bool rwlock_held_for_write(const struct rwlock *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
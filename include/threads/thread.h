@@ -139,6 +139,8 @@ struct thread {
     struct list_elem elem; /* List element. */
 
     //	$우선순위 기부
+    /** @brief 기부를 반영한 유효 우선순위 캐시. priority와 donor_list가 바뀔 때 갱신 */
+    int eff_priority;
     struct lock *wait_on_lock;
     struct list donor_list;
     struct list_elem donor_elem;
@@ -215,9 +217,11 @@ void thread_awake(void);
 
 // $feat/thread_priority_less
 bool thread_priority_less(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
+void thread_reorder(struct thread *t);
 // feat/thread_priority_less
 
 int get_effective_priority(struct thread *);  //	$우선순위 기부
+void thread_refresh_priority(struct thread *);
 int thread_get_priority(void);
 void thread_set_priority(int);
 
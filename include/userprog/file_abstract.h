@@ -6,9 +6,14 @@
 enum file_type { STDIN, STDOUT, FILE, DIRECTORY };
 struct File {
     enum file_type type;
-    struct file* file_ptr;
+    union {
+        struct file* file_ptr; /* FILE */
+        struct dir* dir_ptr;   /* DIRECTORY */
+    };
 };
 
+struct iovec;
+
 extern struct File STDIN_FILE;
 extern struct File STDOUT_FILE;
 
@@ -115,6 +120,97 @@ struct File* duplicate_file(struct File* file);
 
 bool is_file_writable(struct File* file);
 
+/**
+ * @brief 디렉토리의 다음 엔트리 이름 하나를 읽습니다.
+ *
+ * @param file 디렉토리 파일 객체
+ * @param name 이름을 저장할 버퍼 (NAME_MAX + 1 바이트)
+ * @return 읽었으면 true, 디렉토리가 아니거나 남은 엔트리가 없으면 false
+ */
+bool readdir_file(struct File* file, char* name);
+
+/**
+ * @brief 디렉토리 엔트리들을 struct dirent 레코드로 버퍼에 채웁니다.
+ *
+ * 버퍼에 들어가는 만큼의 엔트리를 한 번에 읽어 연속된 레코드로 기록합니다.
+ *
+ * @param file 디렉토리 파일 객체
+ * @param buffer 레코드를 기록할 버퍼
+ * @param size 버퍼 크기(바이트)
+ * @return 기록한 바이트 수, 끝에 도달하면 0,
+ *         디렉토리가 아니거나 첫 레코드도 들어가지 않으면 -1
+ */
+int getdents_file(struct File* file, void* buffer, unsigned size);
+
+/**
+ * @brief 파일 커서를 움직이지 않고 지정한 오프셋에서 읽습니다.
+ *
+ * @param file 데이터를 읽을 파일 객체
+ * @param buffer 읽어온 데이터를 저장할 버퍼
+ * @param size 읽을 바이트 수
+ * @param offset 읽기 시작할 파일 내 위치
+ * @return 실제로 읽은 바이트 수, 일반 파일이 아니거나 offset이 음수이면 -1
+ */
+int pread_file(struct File* file, void* buffer, off_t size, off_t offset);
+
+/**
+ * @brief 파일 커서를 움직이지 않고 지정한 오프셋에 씁니다.
+ *
+ * @param file 데이터를 쓸 파일 객체
+ * @param buffer 기록할 데이터가 담긴 버퍼
+ * @param size 쓸 바이트 수
+ * @param offset 쓰기 시작할 파일 내 위치
+ * @return 실제로 기록된 바이트 수, 일반 파일이 아니거나 offset이 음수이면 -1
+ */
+off_t pwrite_file(struct File* file, const void* buffer, off_t size, off_t offset);
+
+/**
+ * @brief 여러 버퍼에 차례로 읽어 들입니다.
+ *
+ * 앞 버퍼가 다 채워지지 않으면(파일 끝) 거기서 멈춥니다.
+ * 버퍼들은 호출 전에 모두 검증되어 있어야 합니다.
+ *
+ * @param file 데이터를 읽을 파일 객체
+ * @param iov 버퍼 배열
+ * @param iovcnt 버퍼 개수
+ * @return 읽은 바이트 수의 합, 첫 버퍼부터 읽을 수 없으면 -1
+ */
+int readv_file(struct File* file, const struct iovec* iov, int iovcnt);
+
+/**
+ * @brief 여러 버퍼의 내용을 차례로 씁니다.
+ *
+ * @param file 데이터를 쓸 파일 객체
+ * @param iov 버퍼 배열
+ * @param iovcnt 버퍼 개수
+ * @return 기록한 바이트 수의 합, 첫 버퍼부터 쓸 수 없으면 -1
+ */
+int writev_file(struct File* file, const struct iovec* iov, int iovcnt);
+
+/**
+ * @brief 한 파일의 내용을 다른 파일이나 STDOUT으로 커널 안에서 복사합니다.
+ *
+ * 두 파일 모두 현재 커서 위치부터 읽고 쓰며, 커서는 옮긴 만큼 전진합니다.
+ * 데이터는 버퍼 캐시와 커널 페이지 사이에서만 오가고 사용자 메모리를 거치지 않습니다.
+ *
+ * @param in 읽을 파일 객체 (일반 파일)
+ * @param out 쓸 파일 객체 (일반 파일 또는 STDOUT)
+ * @param size 복사할 최대 바이트 수
+ * @return 복사한 바이트 수, 파일 종류가 맞지 않거나 메모리가 부족하면 -1
+ */
+int copy_file(struct File* in, struct File* out, off_t size);
+
+/**
+ * @brief 파일에 쓴 데이터와 메타데이터를 디스크에 반영합니다.
+ *
+ * 버퍼 캐시에 남아 있는 데이터 섹터를 먼저 쓰고, 할당 정보와 저널을 거쳐
+ * 마지막으로 inode를 씁니다.
+ *
+ * @param file 동기화할 파일 또는 디렉토리 객체
+ * @return 성공 시 0, STDIN/STDOUT이면 -1
+ */
+int sync_file(struct File* file);
+
 bool is_same_file(struct File* a, struct File* b);
 
 #endif /* USERPROG_FILE_ABSTRACT_H */
\ No newline at end of file
@@ -300,6 +300,27 @@ bool bitmap_write(const struct bitmap *b, struct file *file) {
     off_t size = byte_cnt(b->bit_cnt);
     return file_write_at(file, b->bits, size, 0) == size;
 }
+
+/* Writes the part of B holding bits START through START + CNT - 1
+   to FILE, at the same place bitmap_write() would put it, so that
+   a change touches only the file sectors it dirtied.  Returns true
+   if successful, false otherwise. */
+bool bitmap_write_range(const struct bitmap *b, struct file *file, size_t start, size_t cnt) {
+    size_t first, last;
+    off_t ofs, size;
+
+    ASSERT(b != NULL);
+    ASSERT(start <= b->bit_cnt);
+    ASSERT(start + cnt <= b->bit_cnt);
+
+    if (cnt == 0)
+        return true;
+    first = elem_idx(start);
+    last = elem_idx(start + cnt - 1);
+    ofs = first * sizeof(elem_type);
+    size = (last - first + 1) * sizeof(elem_type);
+    return file_write_at(file, b->bits + first, size, ofs) == size;
+}
 #endif /* FILESYS */
 
 /* Debugging. */
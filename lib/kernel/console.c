@@ -63,6 +63,7 @@ static int64_t write_cnt;
 /* Enable console locking. */
 void console_init(void) {
     lock_init(&console_lock);
+    lock_register(&console_lock, "console");
     use_console_lock = true;
 }
 
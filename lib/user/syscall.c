@@ -48,8 +48,8 @@ __attribute__((always_inline)) static __inline int64_t syscall(uint64_t num_, ui
 #define syscall3(NUMBER, ARG0, ARG1, ARG2) \
     (syscall(((uint64_t)NUMBER), ((uint64_t)ARG0), ((uint64_t)ARG1), ((uint64_t)ARG2), 0, 0, 0))
 
-#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                                         \
-    (syscall(((uint64_t *)NUMBER), ((uint64_t)ARG0), ((uint64_t)ARG1), ((uint64_t)ARG2), \
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                                       \
+    (syscall(((uint64_t)NUMBER), ((uint64_t)ARG0), ((uint64_t)ARG1), ((uint64_t)ARG2), \
              ((uint64_t)ARG3), 0, 0))
 
 #define syscall5(NUMBER, ARG0, ARG1, ARG2, ARG3, ARG4)                                 \
@@ -149,6 +149,42 @@ int symlink(const char *target, const char *linkpath) {
     return syscall2(SYS_SYMLINK, target, linkpath);
 }
 
+int getdents(int fd, void *buffer, unsigned size) {
+    return syscall3(SYS_GETDENTS, fd, buffer, size);
+}
+
+int fsync(int fd) {
+    return syscall1(SYS_FSYNC, fd);
+}
+
+void sync(void) {
+    syscall0(SYS_SYNC);
+}
+
+int pread(int fd, void *buffer, unsigned size, off_t offset) {
+    return syscall4(SYS_PREAD, fd, buffer, size, offset);
+}
+
+int pwrite(int fd, const void *buffer, unsigned size, off_t offset) {
+    return syscall4(SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int readv(int fd, const struct iovec *iov, int iovcnt) {
+    return syscall3(SYS_READV, fd, iov, iovcnt);
+}
+
+int writev(int fd, const struct iovec *iov, int iovcnt) {
+    return syscall3(SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int copy_file_range(int fd_in, int fd_out, unsigned length) {
+    return syscall3(SYS_COPY_FILE_RANGE, fd_in, fd_out, length);
+}
+
+int sendfile(int out_fd, int in_fd, unsigned length) {
+    return syscall3(SYS_SENDFILE, out_fd, in_fd, length);
+}
+
 int mount(const char *path, int chan_no, int dev_no) {
     return syscall3(SYS_MOUNT, path, chan_no, dev_no);
 }
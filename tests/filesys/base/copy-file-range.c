@@ -0,0 +1,47 @@
+/* Copies one file into another with copy_file_range(), across more
+   than one page, then checks the short copy and the end-of-file
+   cases and that a copy to the console is refused. */
+
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[5000];
+static char expected[6000];
+
+void test_main(void) {
+    int src, dst;
+
+    random_bytes(buf, sizeof buf);
+    CHECK(create("src", 0), "create \"src\"");
+    CHECK(create("dst", 0), "create \"dst\"");
+    CHECK((src = open("src")) > 1, "open \"src\"");
+    CHECK((dst = open("dst")) > 1, "open \"dst\"");
+    CHECK(write(src, buf, sizeof buf) == sizeof buf, "write \"src\"");
+
+    msg("seek \"src\" to 0");
+    seek(src, 0);
+    CHECK(copy_file_range(src, dst, sizeof buf) == sizeof buf, "copy \"src\" to \"dst\"");
+    CHECK(copy_file_range(src, dst, sizeof buf) == 0, "copy at end of file");
+
+    msg("seek \"src\" to 4000");
+    seek(src, 4000);
+    CHECK(copy_file_range(src, dst, sizeof buf) == 1000, "short copy at 4000");
+    CHECK(tell(dst) == sizeof expected, "position of \"dst\" after copies");
+
+    msg("seek \"src\" to 0");
+    seek(src, 0);
+    CHECK(copy_file_range(src, STDOUT_FILENO, 10) == -1, "copy to stdout");
+
+    msg("close \"src\"");
+    close(src);
+    msg("close \"dst\"");
+    close(dst);
+    memcpy(expected, buf, sizeof buf);
+    memcpy(expected + sizeof buf, buf + 4000, 1000);
+    check_file("dst", expected, sizeof expected);
+}
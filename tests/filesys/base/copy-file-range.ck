@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(copy-file-range) begin
+(copy-file-range) create "src"
+(copy-file-range) create "dst"
+(copy-file-range) open "src"
+(copy-file-range) open "dst"
+(copy-file-range) write "src"
+(copy-file-range) seek "src" to 0
+(copy-file-range) copy "src" to "dst"
+(copy-file-range) copy at end of file
+(copy-file-range) seek "src" to 4000
+(copy-file-range) short copy at 4000
+(copy-file-range) position of "dst" after copies
+(copy-file-range) seek "src" to 0
+(copy-file-range) copy to stdout
+(copy-file-range) close "src"
+(copy-file-range) close "dst"
+(copy-file-range) open "dst" for verification
+(copy-file-range) verified contents of "dst"
+(copy-file-range) close "dst"
+(copy-file-range) end
+EOF
+pass;
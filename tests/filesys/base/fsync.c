@@ -0,0 +1,33 @@
+/* Writes a file and checks that fsync() succeeds on it and on the
+   root directory, and returns -1 for stdin and for an fd that is
+   not open. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[1234];
+
+void test_main(void) {
+    const char *file_name = "data";
+    int fd, dir_fd;
+
+    random_bytes(buf, sizeof buf);
+    CHECK(create(file_name, 0), "create \"%s\"", file_name);
+    CHECK((fd = open(file_name)) > 1, "open \"%s\"", file_name);
+    CHECK(write(fd, buf, sizeof buf) == sizeof buf, "write \"%s\"", file_name);
+    CHECK(fsync(fd) == 0, "fsync \"%s\"", file_name);
+    msg("close \"%s\"", file_name);
+    close(fd);
+    check_file(file_name, buf, sizeof buf);
+
+    CHECK((dir_fd = open("/")) > 1, "open \"/\"");
+    CHECK(fsync(dir_fd) == 0, "fsync \"/\"");
+    close(dir_fd);
+
+    CHECK(fsync(STDIN_FILENO) == -1, "fsync stdin");
+    CHECK(fsync(123) == -1, "fsync a bad fd");
+}
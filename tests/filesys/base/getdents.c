@@ -0,0 +1,70 @@
+/* Lists the root directory with getdents() and checks that the
+   records are packed back to back with sane lengths, that every
+   created file and directory is listed exactly once with the
+   right type, that the end of the directory reads as 0, and that
+   bad arguments are rejected. */
+
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static const char *names[] = {"alpha", "beta", "gamma", "delta", "sub"};
+#define NAME_CNT (sizeof names / sizeof *names)
+#define FILE_CNT (NAME_CNT - 1) /* The last name is a directory. */
+
+void test_main(void) {
+    char buf[512];
+    bool seen[NAME_CNT];
+    int fd, file_fd, n;
+    size_t i;
+
+    for (i = 0; i < NAME_CNT; i++)
+        seen[i] = false;
+    for (i = 0; i < FILE_CNT; i++)
+        CHECK(create(names[i], 0), "create \"%s\"", names[i]);
+    CHECK(mkdir(names[FILE_CNT]), "mkdir \"%s\"", names[FILE_CNT]);
+    CHECK((fd = open("/")) > 1, "open \"/\"");
+
+    msg("getdents \"/\"");
+    while ((n = getdents(fd, buf, sizeof buf)) > 0) {
+        int ofs = 0;
+
+        while (ofs < n) {
+            struct dirent *d = (struct dirent *)(buf + ofs);
+            size_t len = strlen(d->d_name);
+
+            if (d->d_reclen < sizeof *d + len + 1 || d->d_reclen % sizeof(int) != 0 ||
+                ofs + d->d_reclen > n)
+                fail("bad record length %d for \"%s\"", d->d_reclen, d->d_name);
+            for (i = 0; i < NAME_CNT; i++)
+                if (!strcmp(d->d_name, names[i])) {
+                    int type = i < FILE_CNT ? DT_REG : DT_DIR;
+                    if (seen[i])
+                        fail("\"%s\" listed twice", names[i]);
+                    if (d->d_type != type)
+                        fail("\"%s\" has type %d, not %d", names[i], d->d_type, type);
+                    seen[i] = true;
+                }
+            ofs += d->d_reclen;
+        }
+    }
+    if (n < 0)
+        fail("getdents returned %d", n);
+    for (i = 0; i < FILE_CNT; i++)
+        CHECK(seen[i], "\"%s\" listed", names[i]);
+    CHECK(seen[FILE_CNT], "\"%s\" listed as a directory", names[FILE_CNT]);
+    CHECK(getdents(fd, buf, sizeof buf) == 0, "getdents at end of directory");
+    close(fd);
+
+    CHECK((fd = open("/")) > 1, "open \"/\"");
+    CHECK(getdents(fd, buf, 4) == -1, "getdents into a 4-byte buffer");
+    close(fd);
+
+    CHECK((file_fd = open("alpha")) > 1, "open \"alpha\"");
+    CHECK(getdents(file_fd, buf, sizeof buf) == -1, "getdents on a file");
+    close(file_fd);
+
+    CHECK(getdents(123, buf, sizeof buf) == -1, "getdents on a bad fd");
+}
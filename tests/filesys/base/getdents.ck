@@ -0,0 +1,49 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(getdents) begin
+(getdents) create "alpha"
+(getdents) create "beta"
+(getdents) create "gamma"
+(getdents) create "delta"
+(getdents) mkdir "sub"
+(getdents) open "/"
+(getdents) getdents "/"
+(getdents) "alpha" listed
+(getdents) "beta" listed
+(getdents) "gamma" listed
+(getdents) "delta" listed
+(getdents) "sub" listed as a directory
+(getdents) getdents at end of directory
+(getdents) open "/"
+(getdents) getdents into a 4-byte buffer
+(getdents) open "alpha"
+(getdents) getdents on a file
+(getdents) getdents on a bad fd
+(getdents) end
+getdents: exit(0)
+EOF
+(getdents) begin
+(getdents) create "alpha"
+(getdents) create "beta"
+(getdents) create "gamma"
+(getdents) create "delta"
+(getdents) mkdir "sub"
+(getdents) open "/"
+(getdents) getdents "/"
+(getdents) "alpha" listed
+(getdents) "beta" listed
+(getdents) "gamma" listed
+(getdents) "delta" listed
+(getdents) "sub" listed as a directory
+(getdents) getdents at end of directory
+(getdents) open "/"
+(getdents) getdents into a 4-byte buffer
+(getdents) open "alpha"
+(getdents) getdents on a file
+(getdents) getdents on a bad fd
+getdents: exit(-1)
+EOF
+pass;
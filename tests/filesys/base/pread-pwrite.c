@@ -0,0 +1,46 @@
+/* Reads and writes a file at explicit offsets with pread() and
+   pwrite(), checking that the file position does not move and that
+   reads past the end of the file come up short. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[600];
+static char patch[100];
+static char rbuf[600];
+
+void test_main(void) {
+    const char *file_name = "data";
+    int fd;
+
+    random_bytes(buf, sizeof buf);
+    random_bytes(patch, sizeof patch);
+    CHECK(create(file_name, 0), "create \"%s\"", file_name);
+    CHECK((fd = open(file_name)) > 1, "open \"%s\"", file_name);
+    CHECK(write(fd, buf, sizeof buf) == sizeof buf, "write \"%s\"", file_name);
+    msg("seek \"%s\" to 10", file_name);
+    seek(fd, 10);
+
+    CHECK(pwrite(fd, patch, sizeof patch, 200) == sizeof patch, "pwrite at 200");
+    memcpy(buf + 200, patch, sizeof patch);
+    CHECK(tell(fd) == 10, "position unchanged after pwrite");
+
+    CHECK(pread(fd, rbuf, sizeof rbuf, 0) == sizeof rbuf, "pread at 0");
+    if (memcmp(rbuf, buf, sizeof buf))
+        fail("pread returned wrong data");
+    CHECK(tell(fd) == 10, "position unchanged after pread");
+
+    CHECK(pread(fd, rbuf, 100, 550) == 50, "short pread at 550");
+    if (memcmp(rbuf, buf + 550, 50))
+        fail("short pread returned wrong data");
+    CHECK(pread(fd, rbuf, 100, sizeof buf) == 0, "pread at end of file");
+    CHECK(tell(fd) == 10, "position still unchanged");
+
+    msg("close \"%s\"", file_name);
+    close(fd);
+    check_file(file_name, buf, sizeof buf);
+}
@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) create "data"
+(pread-pwrite) open "data"
+(pread-pwrite) write "data"
+(pread-pwrite) seek "data" to 10
+(pread-pwrite) pwrite at 200
+(pread-pwrite) position unchanged after pwrite
+(pread-pwrite) pread at 0
+(pread-pwrite) position unchanged after pread
+(pread-pwrite) short pread at 550
+(pread-pwrite) pread at end of file
+(pread-pwrite) position still unchanged
+(pread-pwrite) close "data"
+(pread-pwrite) open "data" for verification
+(pread-pwrite) verified contents of "data"
+(pread-pwrite) close "data"
+(pread-pwrite) end
+EOF
+pass;
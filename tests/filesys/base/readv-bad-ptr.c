@@ -0,0 +1,17 @@
+/* Passes an iovec array at a kernel address to readv().
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+    int fd;
+
+    CHECK(create("data", 123), "create \"data\"");
+    CHECK((fd = open("data")) > 1, "open \"data\"");
+
+    readv(fd, (struct iovec *)0x8004000000, 1);
+    fail("should not have survived readv()");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-bad-ptr) begin
+(readv-bad-ptr) create "data"
+(readv-bad-ptr) open "data"
+readv-bad-ptr: exit(-1)
+EOF
+pass;
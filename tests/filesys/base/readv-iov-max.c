@@ -0,0 +1,23 @@
+/* Passes IOV_MAX + 1 valid buffers to readv().  The call must be
+   rejected, either by returning -1 or by terminating the process
+   with exit code -1. */
+
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[IOV_MAX + 1];
+
+void test_main(void) {
+    struct iovec iov[IOV_MAX + 1];
+    int fd, i;
+
+    CHECK(create("data", sizeof buf), "create \"data\"");
+    CHECK((fd = open("data")) > 1, "open \"data\"");
+    for (i = 0; i < IOV_MAX + 1; i++) {
+        iov[i].iov_base = buf + i;
+        iov[i].iov_len = 1;
+    }
+    CHECK(readv(fd, iov, IOV_MAX + 1) == -1, "readv with IOV_MAX + 1 buffers");
+}
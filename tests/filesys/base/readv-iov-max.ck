@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(readv-iov-max) begin
+(readv-iov-max) create "data"
+(readv-iov-max) open "data"
+(readv-iov-max) readv with IOV_MAX + 1 buffers
+(readv-iov-max) end
+readv-iov-max: exit(0)
+EOF
+(readv-iov-max) begin
+(readv-iov-max) create "data"
+(readv-iov-max) open "data"
+readv-iov-max: exit(-1)
+EOF
+pass;
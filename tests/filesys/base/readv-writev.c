@@ -0,0 +1,56 @@
+/* Writes a file from three buffers with writev() and reads it back
+   with readv(), including a read that runs into the end of the
+   file partway through the second buffer. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[401];
+static char rbuf[401];
+
+void test_main(void) {
+    const char *file_name = "data";
+    struct iovec iov[3];
+    int fd;
+
+    random_bytes(buf, sizeof buf);
+    CHECK(create(file_name, 0), "create \"%s\"", file_name);
+    CHECK((fd = open(file_name)) > 1, "open \"%s\"", file_name);
+
+    iov[0].iov_base = buf;
+    iov[0].iov_len = 100;
+    iov[1].iov_base = buf + 100;
+    iov[1].iov_len = 1;
+    iov[2].iov_base = buf + 101;
+    iov[2].iov_len = 300;
+    CHECK(writev(fd, iov, 3) == sizeof buf, "writev \"%s\"", file_name);
+    CHECK(tell(fd) == sizeof buf, "position after writev");
+
+    msg("seek \"%s\" to 0", file_name);
+    seek(fd, 0);
+    iov[0].iov_base = rbuf;
+    iov[1].iov_base = rbuf + 100;
+    iov[2].iov_base = rbuf + 101;
+    CHECK(readv(fd, iov, 3) == sizeof rbuf, "readv \"%s\"", file_name);
+    if (memcmp(rbuf, buf, sizeof buf))
+        fail("readv returned wrong data");
+
+    msg("seek \"%s\" to 350", file_name);
+    seek(fd, 350);
+    iov[0].iov_base = rbuf;
+    iov[0].iov_len = 40;
+    iov[1].iov_base = rbuf + 40;
+    iov[1].iov_len = 40;
+    CHECK(readv(fd, iov, 2) == 51, "short readv at 350");
+    if (memcmp(rbuf, buf + 350, 51))
+        fail("short readv returned wrong data");
+    CHECK(readv(fd, iov, 2) == 0, "readv at end of file");
+
+    msg("close \"%s\"", file_name);
+    close(fd);
+    check_file(file_name, buf, sizeof buf);
+}
@@ -0,0 +1,13 @@
+/* Passes an fd that is not open as the source of sendfile().
+   The call must fail with -1 or terminate the process with -1
+   exit code. */
+
+#include <stdio.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+    CHECK(sendfile(STDOUT_FILENO, 123, 10) == -1, "sendfile from a bad fd");
+}
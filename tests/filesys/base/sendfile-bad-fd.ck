@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(sendfile-bad-fd) begin
+(sendfile-bad-fd) sendfile from a bad fd
+(sendfile-bad-fd) end
+sendfile-bad-fd: exit(0)
+EOF
+(sendfile-bad-fd) begin
+sendfile-bad-fd: exit(-1)
+EOF
+pass;
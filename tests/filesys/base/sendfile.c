@@ -0,0 +1,37 @@
+/* Sends a file to the console with sendfile(), then checks that a
+   second call at the end of the file returns 0 and that sendfile()
+   also copies between two files. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static const char text[] = "This line was copied to the console by sendfile().\n";
+
+void test_main(void) {
+    int fd, copy_fd;
+
+    CHECK(create("text", 0), "create \"text\"");
+    CHECK((fd = open("text")) > 1, "open \"text\"");
+    CHECK(write(fd, text, strlen(text)) == (int)strlen(text), "write \"text\"");
+
+    msg("seek \"text\" to 0");
+    seek(fd, 0);
+    CHECK(sendfile(STDOUT_FILENO, fd, 100) == (int)strlen(text), "sendfile to stdout");
+    CHECK(sendfile(STDOUT_FILENO, fd, 100) == 0, "sendfile at end of file");
+
+    CHECK(create("copy", 0), "create \"copy\"");
+    CHECK((copy_fd = open("copy")) > 1, "open \"copy\"");
+    msg("seek \"text\" to 0");
+    seek(fd, 0);
+    CHECK(sendfile(copy_fd, fd, strlen(text)) == (int)strlen(text), "sendfile to \"copy\"");
+
+    msg("close \"text\"");
+    close(fd);
+    msg("close \"copy\"");
+    close(copy_fd);
+    check_file("copy", text, strlen(text));
+}
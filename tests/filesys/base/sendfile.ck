@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(sendfile) begin
+(sendfile) create "text"
+(sendfile) open "text"
+(sendfile) write "text"
+(sendfile) seek "text" to 0
+This line was copied to the console by sendfile().
+(sendfile) sendfile to stdout
+(sendfile) sendfile at end of file
+(sendfile) create "copy"
+(sendfile) open "copy"
+(sendfile) seek "text" to 0
+(sendfile) sendfile to "copy"
+(sendfile) close "text"
+(sendfile) close "copy"
+(sendfile) open "copy" for verification
+(sendfile) verified contents of "copy"
+(sendfile) close "copy"
+(sendfile) end
+EOF
+pass;
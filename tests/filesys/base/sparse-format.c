@@ -0,0 +1,29 @@
+/* Boots with -sparse -f, so the file system is formatted while
+   new inodes default to the sparse indexed layout, then checks
+   that a file with a hole in it can be written and read back.
+
+   Only the userprog and vm builds exercise the sparse layout.  The
+   filesys build (EFILESYS) always creates FAT inodes, so there
+   -sparse has no effect and this is a plain hole test. */
+
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[12345];
+
+void test_main(void) {
+    const char *file_name = "sparse";
+    int fd;
+
+    CHECK(create(file_name, 0), "create \"%s\"", file_name);
+    CHECK((fd = open(file_name)) > 1, "open \"%s\"", file_name);
+    msg("seek \"%s\"", file_name);
+    seek(fd, sizeof buf - 100);
+    buf[sizeof buf - 1] = 'x';
+    CHECK(write(fd, buf + sizeof buf - 100, 100) == 100, "write \"%s\"", file_name);
+    msg("close \"%s\"", file_name);
+    close(fd);
+    check_file(file_name, buf, sizeof buf);
+}
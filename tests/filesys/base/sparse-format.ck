@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+# -sparse does nothing in the FAT (EFILESYS) build, so only the userprog
+# and vm builds exercise the sparse layout here.
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(sparse-format) begin
+(sparse-format) create "sparse"
+(sparse-format) open "sparse"
+(sparse-format) seek "sparse"
+(sparse-format) write "sparse"
+(sparse-format) close "sparse"
+(sparse-format) open "sparse" for verification
+(sparse-format) verified contents of "sparse"
+(sparse-format) close "sparse"
+(sparse-format) end
+EOF
+pass;
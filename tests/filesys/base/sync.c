@@ -0,0 +1,40 @@
+/* Writes two files, calls sync(), and checks that both still read
+   back correctly, including after one of them is removed and
+   sync() is called again. */
+
+#include <random.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf_a[2345];
+static char buf_b[567];
+
+static void write_file(const char *file_name, const char *buf, size_t size) {
+    int fd;
+
+    CHECK(create(file_name, 0), "create \"%s\"", file_name);
+    CHECK((fd = open(file_name)) > 1, "open \"%s\"", file_name);
+    CHECK(write(fd, buf, size) == (int)size, "write \"%s\"", file_name);
+    msg("close \"%s\"", file_name);
+    close(fd);
+}
+
+void test_main(void) {
+    random_bytes(buf_a, sizeof buf_a);
+    random_bytes(buf_b, sizeof buf_b);
+    write_file("a", buf_a, sizeof buf_a);
+    write_file("b", buf_b, sizeof buf_b);
+
+    msg("sync");
+    sync();
+    check_file("a", buf_a, sizeof buf_a);
+    check_file("b", buf_b, sizeof buf_b);
+
+    CHECK(remove("a"), "remove \"a\"");
+    msg("sync");
+    sync();
+    CHECK(open("a") == -1, "open \"a\" after removal");
+    check_file("b", buf_b, sizeof buf_b);
+}
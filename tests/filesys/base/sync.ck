@@ -0,0 +1,30 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(sync) begin
+(sync) create "a"
+(sync) open "a"
+(sync) write "a"
+(sync) close "a"
+(sync) create "b"
+(sync) open "b"
+(sync) write "b"
+(sync) close "b"
+(sync) sync
+(sync) open "a" for verification
+(sync) verified contents of "a"
+(sync) close "a"
+(sync) open "b" for verification
+(sync) verified contents of "b"
+(sync) close "b"
+(sync) remove "a"
+(sync) sync
+(sync) open "a" after removal
+(sync) open "b" for verification
+(sync) verified contents of "b"
+(sync) close "b"
+(sync) end
+EOF
+pass;
@@ -36,8 +36,13 @@
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
+#include "filesys/dcache.h"
+#include "filesys/fat.h"
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
+#include "filesys/inode.h"
+#include "filesys/journal.h"
+#include "filesys/page_cache.h"
 #endif
 
 /* Page-map-level-4 with kernel mappings only. */
@@ -212,6 +217,12 @@ static char **parse_options(char **argv) {
 #ifdef FILESYS
         else if (!strcmp(name, "-f"))
             format_filesys = true;
+        else if (!strcmp(name, "-sparse"))
+            inode_default_layout = INODE_INDEXED;
+#endif
+#ifdef EFILESYS
+        else if (!strcmp(name, "-cluster"))
+            fat_format_cluster_sectors = atoi(value);
 #endif
         else if (!strcmp(name, "-rs"))
             random_init(atoi(value));
@@ -314,6 +325,12 @@ static void usage(void) {
         "  -h                 Print this help message and power off.\n"
         "  -q                 Power off VM after actions or on panic.\n"
         "  -f                 Format file system disk during startup.\n"
+#ifdef FILESYS
+        "  -sparse            Create files with the sparse indexed inode layout.\n"
+#endif
+#ifdef EFILESYS
+        "  -cluster=SECTORS   Format with SECTORS sectors per cluster (default 8).\n"
+#endif
         "  -rs=SEED           Set random number seed to SEED.\n"
         "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
@@ -341,8 +358,12 @@ void power_off(void) {
 static void print_stats(void) {
     timer_print_stats();
     thread_print_stats();
+    lock_print_stats();
 #ifdef FILESYS
     disk_print_stats();
+    page_cache_print_stats();
+    dcache_print_stats();
+    journal_print_stats();
 #endif
     console_print_stats();
     kbd_print_stats();
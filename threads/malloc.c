@@ -42,6 +42,7 @@ struct desc {
     size_t blocks_per_arena; /* Number of blocks in an arena. */
     struct list free_list;   /* List of free blocks. */
     struct lock lock;        /* Lock. */
+    char lock_name[16];      /* Name for lock statistics. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -77,6 +78,8 @@ void malloc_init(void) {
         d->blocks_per_arena = (PGSIZE - sizeof(struct arena)) / block_size;
         list_init(&d->free_list);
         lock_init(&d->lock);
+        snprintf(d->lock_name, sizeof d->lock_name, "malloc %zu", block_size);
+        lock_register(&d->lock, d->lock_name);
     }
 }
 
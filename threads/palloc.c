@@ -187,6 +187,9 @@ static void populate_pools(struct area *base_mem, struct area *ext_mem) {
     // generate the user pool
     init_pool(&user_pool, &free_start, region_start, end);
 
+    lock_register(&kernel_pool.lock, "kernel pool");
+    lock_register(&user_pool.lock, "user pool");
+
     // Iterate over the e820_entry. Setup the usable.
     uint64_t usable_bound = (uint64_t)free_start;
     struct pool *pool;
@@ -31,9 +31,16 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "devices/timer.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
+/* Locks reported by lock_print_stats().  Only long-lived locks
+   (static or embedded in static structures) may be registered. */
+#define LOCK_REGISTRY_MAX 32
+static struct lock *lock_registry[LOCK_REGISTRY_MAX];
+static size_t lock_registry_cnt;
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -67,7 +74,9 @@ void sema_down(struct semaphore *sema) {
     old_level = intr_disable();
     while (sema->value == 0) {
         // $feat/thread-priority-sema
-        list_push_back(&sema->waiters, &thread_current()->elem);
+        /* waiters는 유효 우선순위 내림차순으로 유지하여 sema_up이 front만 꺼내도록 한다. */
+        SortOrder order = DESCENDING;
+        list_insert_ordered(&sema->waiters, &thread_current()->elem, thread_priority_less, &order);
         // feat/thread-priority-sema
         thread_block();
     }
@@ -97,6 +106,33 @@ bool sema_try_down(struct semaphore *sema) {
     return success;
 }
 
+/**
+ * @brief SEMA의 대기자 중 가장 높은 우선순위 스레드 하나를 깨우고 value를 올리는 함수
+ *
+ * 선점(yield)은 하지 않고, 깨운 스레드가 현재 스레드보다 높은 유효 우선순위를
+ * 가져 선점이 필요한지만 반환한다. 호출자는 임계 구역이 끝나는 지점에서
+ * 한 번만 선점 여부를 처리하면 된다.
+ *
+ * 인터럽트가 비활성화된 상태에서 호출되어야 한다.
+ *
+ * @return 깨운 스레드가 현재 스레드보다 우선순위가 높으면 true
+ */
+static bool sema_wake(struct semaphore *sema) {
+    bool preempt = false;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (!list_empty(&sema->waiters)) {
+        /* waiters는 내림차순 정렬이 유지되므로 front가 가장 높은 우선순위. */
+        struct thread *t = list_entry(list_pop_front(&sema->waiters), struct thread, elem);
+        thread_unblock(t);
+        preempt = t->eff_priority > thread_current()->eff_priority;
+    }
+    sema->value++;
+
+    return preempt;
+}
+
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
    and wakes up one thread of those waiting for SEMA, if any.
 
@@ -107,18 +143,10 @@ void sema_up(struct semaphore *sema) {
     ASSERT(sema != NULL);
 
     old_level = intr_disable();
-    if (!list_empty(&sema->waiters)) {
-        // max로 하면 실패하고 min으로 하면 성공함 thread_priority_less가 > 일때 리턴이라
-        // 그렇구나...
-        SortOrder order = ASECENDING;
-        struct list_elem *max_elem = list_max(&sema->waiters, thread_priority_less, &order);
-        list_remove(max_elem);
-        thread_unblock(list_entry(max_elem, struct thread, elem));
-    }
-
-    sema->value++;
-
-    thread_yield_r();
+    /* 더 높은 우선순위 스레드를 깨웠을 때만 양보한다.
+     * 인터럽트 컨텍스트라면 thread_yield_r가 intr_yield_on_return으로 미룬다. */
+    if (sema_wake(sema))
+        thread_yield_r();
     intr_set_level(old_level);
 }
 
@@ -173,6 +201,35 @@ void lock_init(struct lock *lock) {
 
     lock->holder = NULL;
     sema_init(&lock->semaphore, 1);
+    memset(&lock->stats, 0, sizeof lock->stats);
+}
+
+/**
+ * @brief 방금 LOCK을 얻은 현재 스레드를 보유자로 기록하는 함수
+ *
+ * 아직 LOCK을 기다리는 스레드들은 이전 보유자가 해제할 때 그쪽 donor_list에서
+ * 빠졌으므로, 새 보유자인 현재 스레드의 기부자로 옮기고 eff_priority를
+ * 증분으로 끌어올린다. 현재 스레드는 실행 중이므로 재배치는 필요 없다.
+ *
+ * 인터럽트가 비활성화된 상태에서 호출되어야 한다.
+ */
+static void lock_set_holder(struct lock *lock) {
+    struct thread *cur = thread_current();
+    struct list_elem *e;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    for (e = list_begin(&lock->semaphore.waiters); e != list_end(&lock->semaphore.waiters);
+         e = list_next(e)) {
+        struct thread *waiter = list_entry(e, struct thread, elem);
+        list_push_back(&cur->donor_list, &waiter->donor_elem);
+        if (waiter->eff_priority > cur->eff_priority)
+            cur->eff_priority = waiter->eff_priority;
+    }
+
+    lock->holder = cur;
+    lock->stats.acquire_cnt++;
+    lock->stats.acquired_at = timer_ticks();
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -189,24 +246,17 @@ void lock_init(struct lock *lock) {
  * 락이 이미 다른 스레드에 의해 보유되고 있을 때, 현재 스레드의 우선순위를
  * 락 보유자에게 기부하여 우선순위 역전 문제를 해결
  *
- * 우선순위 기부는 다음과 같은 상황에서 발생합니다:
- * - 높은 우선순위 스레드가 낮은 우선순위 스레드가 보유한 락을 기다릴 때
- * - 기부 체인이 형성되어 우선순위가 연쇄적으로 전파될 때
+ * 각 스레드는 캐시된 유효 우선순위(eff_priority)를 가지며, 기부는 이 값을
+ * 증분으로 갱신한다. 스케줄러의 비교는 필드 하나를 읽는 것으로 끝난다.
  *
  * 동작 과정:
  * 1. 락 획득 시도 (sema_try_down)
- * 2. 실패 시 우선순위 기부 로직 실행:
- *    a) 중복 기부 제거: 같은 락을 기다리는 기존 기부자 찾아서 제거
- *    b) 새로운 기부 관계 설정: donor의 donor_list를 holder에 추가
- *    c) 기부 체인 전파: holder가 다른 락을 기다린다면 기부 체인 확장
- *    d) 우선순위 재정렬: 기부 후 우선순위 순서로 정렬
+ * 2. 실패 시 우선순위 기부:
+ *    a) 현재 스레드를 holder의 donor_list에 직접 기부자로 추가
+ *    b) wait_on_lock 체인을 따라 올라가며 더 낮은 eff_priority를 끌어올리고
+ *       각자의 대기열에서 재배치 (최대 DONATION_DEPTH_MAX 단계)
  * 3. 락 대기 (sema_down)
- * 4. 락 보유자 설정
- *
- * 주의사항:
- * - 인터럽트가 비활성화된 상태에서 실행되어야 함
- * - donor_list는 우선순위 순서로 정렬되어야 함
- * - 기부 체인은 무한 루프를 방지하기 위해 주의 깊게 처리
+ * 4. 락 보유자 설정 (lock_set_holder)
  *
  * @param lock 획득할 락
  */
@@ -218,38 +268,31 @@ void lock_acquire(struct lock *lock) {
     enum intr_level old_level;
     old_level = intr_disable();
     if (!sema_try_down(&lock->semaphore)) {
-        struct thread *donor = thread_current(), *holder = lock->holder;
-        donor->wait_on_lock = lock;
-        struct list_elem *e = list_next(list_begin(&holder->donor_list));
-
-        while (e != list_end(&holder->donor_list) && e->next != NULL) {
-            struct thread *existing_donor = list_entry(e, struct thread, donor_elem);
-            if (existing_donor->wait_on_lock == lock) {
-                list_extract(&existing_donor->donor_list);
-                break;
-            }
-            e = list_next(e);
-        }
+        struct thread *cur = thread_current(), *t, *holder;
+        int64_t wait_start = timer_ticks();
+        int depth;
 
-        list_extend(&holder->donor_list, &donor->donor_list);
-        struct thread *cur = holder, *cur_holder;
-        struct list_elem *donor_end = list_back(&donor->donor_list);
+        cur->wait_on_lock = lock;
+        list_push_back(&lock->holder->donor_list, &cur->donor_elem);
 
-        while (cur->wait_on_lock && (cur_holder = cur->wait_on_lock->holder) != NULL) {
-            list_tail(&cur_holder->donor_list)->prev = donor_end;
-            donor_end->next = list_tail(&cur_holder->donor_list);
-            cur = cur_holder;
+        /* 체인을 따라 기부를 전파. 이미 충분히 높은 스레드를 만나면 위쪽도 이미 높다. */
+        for (t = cur, depth = 0; depth < DONATION_DEPTH_MAX && t->wait_on_lock != NULL; depth++) {
+            holder = t->wait_on_lock->holder;
+            if (holder == NULL || holder->eff_priority >= t->eff_priority)
+                break;
+            holder->eff_priority = t->eff_priority;
+            thread_reorder(holder);
+            t = holder;
         }
 
-        struct list *holder_list = find_list(&holder->elem);
-        SortOrder order = DESCENDING;
-        list_sort(holder_list, thread_priority_less, &order);
-
         sema_down(&lock->semaphore);
+        cur->wait_on_lock = NULL;
+
+        lock->stats.contended_cnt++;
+        lock->stats.wait_ticks += timer_elapsed(wait_start);
     }
+    lock_set_holder(lock);
     intr_set_level(old_level);
-
-    lock->holder = thread_current();
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -264,9 +307,11 @@ bool lock_try_acquire(struct lock *lock) {
     ASSERT(lock != NULL);
     ASSERT(!lock_held_by_current_thread(lock));
 
+    enum intr_level old_level = intr_disable();
     success = sema_try_down(&lock->semaphore);
     if (success)
-        lock->holder = thread_current();
+        lock_set_holder(lock);
+    intr_set_level(old_level);
     return success;
 }
 
@@ -279,29 +324,16 @@ bool lock_try_acquire(struct lock *lock) {
 /**
  * @brief 락을 해제하고 우선순위 기부를 정리하는 함수
  *
- * 현재 스레드가 보유하고 있는 락을 해제하고, 해당 락을 기다리고 있던
- * 스레드들에게 우선순위 기부를 정리
- *
- * 우선순위 기부 정리는 다음과 같은 이유로 중요:
- * - 락이 해제되면 기부 관계가 더 이상 필요하지 않음
- * - 기부받은 우선순위를 원래 우선순위로 복원해야 함
- * - 기부 체인에서 해당 스레드를 제거해야 함
+ * 현재 스레드가 보유하고 있는 락을 해제하고, 해당 락을 기다리며 기부하던
+ * 스레드들을 donor_list에서 제거한 뒤 캐시된 유효 우선순위를 다시 계산
  *
  * 동작 과정:
  * 1. 인터럽트 비활성화 (원자적 연산 보장)
- * 2. 대기 중인 스레드의 우선순위 기부 정리:
- *    - 세마포어 대기 리스트에서 첫 번째 스레드 선택
- *    - 해당 스레드의 donor_list에서 기부 관계 제거
- *    - wait_on_lock을 NULL로 설정하여 기다리는 락 없음을 표시
- * 3. 락 보유자 정보 제거 (lock->holder = NULL)
- * 4. 세마포어 해제 (대기 중인 스레드 깨우기)
+ * 2. donor_list에서 wait_on_lock == LOCK인 기부자 제거
+ * 3. 남은 기부자와 기본 우선순위로 eff_priority 재계산
+ * 4. 락 보유자 정보 제거 후 세마포어 해제 (대기 중인 스레드 깨우기)
  * 5. 인터럽트 재활성화
  *
- * 주의사항:
- * - 인터럽트가 비활성화된 상태에서 실행되어야 함
- * - 기부 정리 순서가 중요함 (기부자 제거 → 락 해제)
- * - 세마포어 대기 리스트가 비어있을 수 있음
- *
  * @param lock 해제할 락
  */
 void lock_release(struct lock *lock) {
@@ -309,14 +341,19 @@ void lock_release(struct lock *lock) {
     ASSERT(lock_held_by_current_thread(lock));
 
     enum intr_level old_level = intr_disable();
+    struct thread *cur = thread_current();
+    struct list_elem *e;
 
-    if (!list_empty(&lock->semaphore.waiters)) {
-        SortOrder order = ASECENDING;
-        struct thread *release_thread = list_entry(
-            list_max(&lock->semaphore.waiters, thread_priority_less, &order), struct thread, elem);
-        list_extract(&release_thread->donor_list);
-        release_thread->wait_on_lock = NULL;
+    int64_t held = timer_elapsed(lock->stats.acquired_at);
+    if (held > lock->stats.max_hold_ticks)
+        lock->stats.max_hold_ticks = held;
+
+    for (e = list_begin(&cur->donor_list); e != list_end(&cur->donor_list);) {
+        struct thread *donor = list_entry(e, struct thread, donor_elem);
+        e = donor->wait_on_lock == lock ? list_remove(e) : list_next(e);
     }
+    thread_refresh_priority(cur);
+
     lock->holder = NULL;
     sema_up(&lock->semaphore);
     intr_set_level(old_level);
@@ -331,6 +368,42 @@ bool lock_held_by_current_thread(const struct lock *lock) {
     return lock->holder == thread_current();
 }
 
+/**
+ * @brief LOCK을 이름과 함께 통계 레지스트리에 등록하는 함수
+ *
+ * 등록된 락은 종료 시 print_stats()에서 lock_print_stats()로 출력된다.
+ * 레지스트리는 포인터만 보관하므로 전역이거나 전역 구조체에 포함된,
+ * 커널 수명 동안 살아 있는 락만 등록해야 한다.
+ *
+ * @param lock 등록할 락 (lock_init() 이후)
+ * @param name 출력에 쓸 이름, 락과 같은 수명이어야 함
+ */
+void lock_register(struct lock *lock, const char *name) {
+    ASSERT(lock != NULL);
+    ASSERT(name != NULL);
+
+    lock->stats.name = name;
+    if (lock_registry_cnt < LOCK_REGISTRY_MAX)
+        lock_registry[lock_registry_cnt++] = lock;
+}
+
+/* Prints contention statistics for registered locks. */
+void lock_print_stats(void) {
+    size_t i;
+
+    for (i = 0; i < lock_registry_cnt; i++) {
+        struct lock *l = lock_registry[i];
+        struct thread *holder = l->holder;
+
+        printf("Lock %s: %llu acquires, %llu contended, %lld wait ticks, %lld max hold ticks",
+               l->stats.name, l->stats.acquire_cnt, l->stats.contended_cnt, l->stats.wait_ticks,
+               l->stats.max_hold_ticks);
+        if (holder != NULL)
+            printf(", held by %s", holder->name);
+        printf("\n");
+    }
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem {
     struct list_elem elem;      /* List element. */
@@ -378,13 +451,14 @@ void cond_init(struct condition *cond) {
  * @param b 두 번째 세마포어 요소 (struct semaphore_elem의 elem)
  * @return a의 우선순위가 b보다 높으면 true, 그렇지 않으면 false
  */
-int waiter_priority_less(struct list_elem *a, struct list_elem *b) {
+static bool waiter_priority_less(const struct list_elem *a, const struct list_elem *b,
+                                 void *aux UNUSED) {
     struct semaphore_elem *w_a = list_entry(a, struct semaphore_elem, elem);
     struct semaphore_elem *w_b = list_entry(b, struct semaphore_elem, elem);
     struct thread *t_a = list_entry(list_front(&w_a->semaphore.waiters), struct thread, elem);
     struct thread *t_b = list_entry(list_front(&w_b->semaphore.waiters), struct thread, elem);
 
-    return get_effective_priority(t_a) > get_effective_priority(t_b);
+    return t_a->eff_priority > t_b->eff_priority;
 }
 
 void cond_wait(struct condition *cond, struct lock *lock) {
@@ -413,8 +487,9 @@ void cond_wait(struct condition *cond, struct lock *lock) {
  * @brief 조건 변수에서 대기 중인 스레드 중 하나를 깨우는 함수
  *
  * 조건 변수의 대기자 리스트에서 우선순위가 가장 높은 스레드를 선택하여 깨움
- * 우선순위 기부를 고려한 유효 우선순위로 정렬한 후
- * 가장 높은 우선순위의 스레드를 깨움
+ * 대기 중 기부로 우선순위가 바뀔 수 있으므로 매번 정렬하지 않고
+ * 한 번의 순회(list_min)로 가장 높은 우선순위의 대기자를 고름
+ * (waiter_priority_less가 '>' 비교이므로 list_min이 최댓값, 동순위는 FIFO)
  *
  * @param cond 시그널을 보낼 조건 변수
  * @param lock UNUSED 매개변수 (사용되지 않음)
@@ -426,10 +501,10 @@ void cond_signal(struct condition *cond, struct lock *lock UNUSED) {
     ASSERT(lock_held_by_current_thread(lock));
 
     if (!list_empty(&cond->waiters)) {
-        list_sort(&cond->waiters, waiter_priority_less, NULL);
+        struct list_elem *max_elem = list_min(&cond->waiters, waiter_priority_less, NULL);
+        list_remove(max_elem);
 
-        sema_up(
-            &list_entry(list_pop_front(&cond->waiters), struct semaphore_elem, elem)->semaphore);
+        sema_up(&list_entry(max_elem, struct semaphore_elem, elem)->semaphore);
     }
 }
 
@@ -440,8 +515,124 @@ void cond_signal(struct condition *cond, struct lock *lock UNUSED) {
    make sense to try to signal a condition variable within an
    interrupt handler. */
 void cond_broadcast(struct condition *cond, struct lock *lock) {
+    enum intr_level old_level;
+    bool preempt = false;
+
     ASSERT(cond != NULL);
     ASSERT(lock != NULL);
+    ASSERT(!intr_context());
+    ASSERT(lock_held_by_current_thread(lock));
+
+    /* 깨운 스레드는 ready_list에 우선순위 순으로 들어가므로 FIFO로 모두 깨우고,
+     * 선점 여부는 마지막에 한 번만 확인한다. */
+    old_level = intr_disable();
+    while (!list_empty(&cond->waiters)) {
+        struct list_elem *e = list_pop_front(&cond->waiters);
+        preempt |= sema_wake(&list_entry(e, struct semaphore_elem, elem)->semaphore);
+    }
+    if (preempt)
+        thread_yield_r();
+    intr_set_level(old_level);
+}
+
+/**
+ * @brief reader-writer 락을 초기화하는 함수
+ *
+ * rwlock은 공유(read) 모드와 배타(write) 모드를 제공한다.
+ * - writer는 내부 lock을 잡은 채로 기존 reader가 모두 빠져나가기를 기다린 뒤
+ *   임계 구역이 끝날 때까지 lock을 보유한다.
+ * - reader는 진입할 때만 내부 lock을 잠깐 잡았다 놓는다.
+ *
+ * 따라서 writer가 대기 중이거나 보유 중이면 새 reader는 lock에서 막혀
+ * writer가 우선권을 가지며(writer starvation 방지), lock에서 대기하는 스레드는
+ * 기존 donor_list 기반 우선순위 기부로 writer에게 우선순위를 기부한다.
+ *
+ * @param rw 초기화할 reader-writer 락
+ */
+void rwlock_init(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+
+    lock_init(&rw->lock);
+    sema_init(&rw->drained, 0);
+    rw->readers = 0;
+}
+
+/**
+ * @brief RW를 공유 모드로 획득하는 함수
+ *
+ * 보유 중이거나 대기 중인 writer가 있으면 내부 lock에서 잠들며,
+ * 그동안 writer에게 우선순위를 기부한다.
+ *
+ * @param rw 획득할 reader-writer 락
+ */
+void rwlock_acquire_read(struct rwlock *rw) {
+    enum intr_level old_level;
+
+    ASSERT(rw != NULL);
+    ASSERT(!intr_context());
+
+    lock_acquire(&rw->lock);
+    old_level = intr_disable();
+    rw->readers++;
+    intr_set_level(old_level);
+    lock_release(&rw->lock);
+}
+
+/**
+ * @brief 공유 모드로 보유한 RW를 해제하는 함수
+ *
+ * 마지막 reader가 나가면서 reader가 빠지기를 기다리는 writer가 있으면 깨운다.
+ *
+ * @param rw 해제할 reader-writer 락
+ */
+void rwlock_release_read(struct rwlock *rw) {
+    enum intr_level old_level;
+
+    ASSERT(rw != NULL);
+
+    old_level = intr_disable();
+    ASSERT(rw->readers > 0);
+    if (--rw->readers == 0 && !list_empty(&rw->drained.waiters))
+        sema_up(&rw->drained);
+    intr_set_level(old_level);
+}
+
+/**
+ * @brief RW를 배타 모드로 획득하는 함수
+ *
+ * 내부 lock을 먼저 잡아 새 reader의 진입을 막은 뒤, 이미 들어와 있는 reader가
+ * 모두 나갈 때까지 기다린다. lock은 rwlock_release_write()까지 보유한다.
+ *
+ * @param rw 획득할 reader-writer 락
+ */
+void rwlock_acquire_write(struct rwlock *rw) {
+    enum intr_level old_level;
+
+    ASSERT(rw != NULL);
+    ASSERT(!intr_context());
+
+    lock_acquire(&rw->lock);
+    old_level = intr_disable();
+    while (rw->readers > 0) sema_down(&rw->drained);
+    intr_set_level(old_level);
+}
+
+/**
+ * @brief 배타 모드로 보유한 RW를 해제하는 함수
+ *
+ * @param rw 해제할 reader-writer 락
+ */
+void rwlock_release_write(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+    ASSERT(rw->readers == 0);
+
+    lock_release(&rw->lock);
+}
+
+/* Returns true if the current thread holds RW in exclusive
+   mode, false otherwise. */
+bool rwlock_held_for_write(const struct rwlock *rw) {
+    ASSERT(rw != NULL);
 
-    while (!list_empty(&cond->waiters)) cond_signal(cond, lock);
+    return lock_held_by_current_thread(&rw->lock);
 }
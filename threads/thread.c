@@ -49,6 +49,8 @@ static struct list destruction_req;
 static long long idle_ticks;   /* # of timer ticks spent idle. */
 static long long kernel_ticks; /* # of timer ticks in kernel threads. */
 static long long user_ticks;   /* # of timer ticks in user programs. */
+static long long voluntary_switches;   /* # of switches away from a blocked/dying thread. */
+static long long involuntary_switches; /* # of switches away from a still-runnable thread. */
 
 /* Scheduling. */
 #define TIME_SLICE 4          /* # of timer ticks to give each thread. */
@@ -77,6 +79,7 @@ static tid_t allocate_tid(void);
 //$test-temp/mlfqs-iizxcv
 static void threads_recent_update(void);
 static int calaculate_priority(fixed_t recent_cpu, int nice);
+static int donated_priority(struct thread *t);
 static size_t get_count_threads(void);
 static void load_avg_update(void);
 // test-temp/mlfqs-iizxcv
@@ -120,6 +123,7 @@ void thread_init(void) {
 
     /* Init the globla thread context */
     lock_init(&tid_lock);
+    lock_register(&tid_lock, "tid");
     list_init(&ready_list);
     list_init(&destruction_req);
 
@@ -173,6 +177,8 @@ void thread_tick(void) {
 void thread_print_stats(void) {
     printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n", idle_ticks,
            kernel_ticks, user_ticks);
+    printf("Thread: %lld voluntary, %lld involuntary context switches\n", voluntary_switches,
+           involuntary_switches);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -242,12 +248,41 @@ bool thread_priority_less(const struct list_elem *a, const struct list_elem *b,
     struct thread *t_a = list_entry(a, struct thread, elem);
     struct thread *t_b = list_entry(b, struct thread, elem);
     if (*order == ASECENDING) {
-        return get_effective_priority(t_a) < get_effective_priority(t_b);
+        return t_a->eff_priority < t_b->eff_priority;
     } else {
-        return get_effective_priority(t_a) > get_effective_priority(t_b);
+        return t_a->eff_priority > t_b->eff_priority;
     }
 }
 
+/**
+ * @brief 유효 우선순위가 바뀐 스레드를 자신이 속한 대기열에서 정렬된 위치로 옮기는 함수
+ *
+ * ready_list와 세마포어 waiters는 유효 우선순위 내림차순으로 유지되어 front가 항상
+ * 가장 높은 우선순위이다. 우선순위 기부로 T의 유효 우선순위가 바뀌면 T 하나만
+ * 빼서 다시 끼워 넣어 전체 정렬 없이 순서를 복구한다.
+ * 실행 중이거나 sleep_list(wake_tick 정렬)에 있는 스레드는 건드리지 않는다.
+ *
+ * 인터럽트가 비활성화된 상태에서 호출되어야 한다.
+ *
+ * @param t 유효 우선순위가 바뀐 스레드
+ */
+void thread_reorder(struct thread *t) {
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (t->status != THREAD_READY && t->status != THREAD_BLOCKED)
+        return;
+    if (t->elem.prev == NULL || t->elem.next == NULL)
+        return;
+
+    struct list *queue = find_list(&t->elem);
+    if (queue == &sleep_list)
+        return;
+
+    SortOrder order = DESCENDING;
+    list_remove(&t->elem);
+    list_insert_ordered(queue, &t->elem, thread_priority_less, &order);
+}
+
 /* Puts the current thread to sleep.  It will not be scheduled
    again until awoken by thread_unblock().
 
@@ -354,8 +389,8 @@ void thread_yield(void) {
  */
 void thread_yield_r(void) {
     if (!list_empty(&ready_list) &&
-        get_effective_priority(thread_current()) <
-            get_effective_priority(list_entry(list_front(&ready_list), struct thread, elem))) {
+        thread_current()->eff_priority <
+            list_entry(list_front(&ready_list), struct thread, elem)->eff_priority) {
         if (intr_context()) {
             intr_yield_on_return();
         } else {
@@ -427,6 +462,7 @@ void thread_awake(void) {
         list_pop_front(&sleep_list);
         if (thread_mlfqs) {
             t->priority = calaculate_priority(t->recent_cpu, t->nice);
+            t->eff_priority = donated_priority(t);
         }
         thread_unblock(t);
     }
@@ -434,55 +470,68 @@ void thread_awake(void) {
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
 /**
- * @brief 현재 스레드의 우선순위를 새로운 값으로 설정하고, 우선순위 기부 상황을 재조정하는 함수
+ * @brief 현재 스레드의 기본 우선순위를 새로운 값으로 설정하는 함수
  *
- * 현재 스레드의 우선순위가 변경될 때, 기존에 우선순위를 기부받고 있던 donor_list를 검사하여
- * 더 이상 기부가 필요하지 않은 스레드들을 제거합니다.
- *
- * 동작 과정:
- * 1. 현재 스레드의 우선순위를 new_priority로 업데이트
- * 2. donor_list의 각 기부자(donor)를 순회
- * 3. 각 기부자의 유효 우선순위가 새로운 우선순위보다 낮거나 같으면 해당 기부자를 donor_list에서
- * 제거
- * 4. 우선순위 변경 후 스케줄링을 위해 thread_yield() 호출
+ * 기부받은 우선순위는 donor_list에 그대로 남아 있으므로, 기본 우선순위만 바꾸고
+ * thread_refresh_priority()로 캐시된 유효 우선순위를 다시 계산한 뒤 양보한다.
  *
  * @param new_priority 설정할 새로운 우선순위 값
  */
 void thread_set_priority(int new_priority) {
     if (thread_mlfqs == false) {  //$test-temp/mlfqs
+        enum intr_level old_level = intr_disable();
         struct thread *cur = thread_current();
         cur->priority = new_priority;
-
-        struct list_elem *prev = list_front(&cur->donor_list);
-        struct list_elem *e = list_next(prev);
-        while (e != list_tail(&cur->donor_list)) {
-            prev = e->prev;
-            struct thread *donor = list_entry(e, struct thread, donor_elem);
-            int donor_priority = get_effective_priority(donor);
-
-            if (donor_priority <= new_priority) {
-                list_extract(&donor->donor_list);
-                e = list_next(prev);
-            } else {
-                e = list_next(e);
-            }
-        }
+        thread_refresh_priority(cur);
+        intr_set_level(old_level);
     }
 
     thread_yield();
 }
 
 /**
- * @brief  * 기부자의 priority 값을 반환
- * 단, `donor_list`는 **우선순위 오름차순**으로 정렬되야함
- * `list_back()`이 가장 높은 우선순위의 기부자를 가리키는 구조임을 전제
+ * @brief 기본 우선순위와 직접 기부자들의 유효 우선순위 중 최댓값을 계산
+ *
+ * 기부자의 eff_priority는 이미 그 아래 체인을 반영하고 있으므로 직접 기부자만 보면 된다.
+ */
+static int donated_priority(struct thread *t) {
+    int eff = t->priority;
+    struct list_elem *e;
+
+    for (e = list_begin(&t->donor_list); e != list_end(&t->donor_list); e = list_next(e)) {
+        struct thread *donor = list_entry(e, struct thread, donor_elem);
+        if (donor->eff_priority > eff)
+            eff = donor->eff_priority;
+    }
+    return eff;
+}
+
+/**
+ * @brief T의 캐시된 유효 우선순위를 다시 계산하고, 바뀌었으면 대기열에서 재배치
+ *
+ * 기본 우선순위가 바뀌었거나 기부자가 빠졌을 때 호출한다.
+ * 인터럽트가 비활성화된 상태에서 호출되어야 한다.
+ *
+ * @param t 갱신할 스레드
+ */
+void thread_refresh_priority(struct thread *t) {
+    int eff = donated_priority(t);
+
+    if (eff != t->eff_priority) {
+        t->eff_priority = eff;
+        thread_reorder(t);
+    }
+}
+
+/**
+ * @brief 기부를 고려한 T의 유효 우선순위를 반환
+ *
+ * 값은 eff_priority에 캐시되어 있으며 기부와 해제 시점에 증분으로 갱신된다.
  *
  * @param t 우선순위를 확인할 대상 스레드
  * @return 기부를 고려한 현재 유효 우선순위 값*/
-
 int get_effective_priority(struct thread *t) {
-    struct thread *donor_thread = list_entry(list_back(&t->donor_list), struct thread, donor_elem);
-    return donor_thread->priority;
+    return t->eff_priority;
 }
 
 /* Returns the current thread's priority. */
@@ -508,6 +557,7 @@ void thread_set_nice(int nice) {
     struct thread *t = thread_current();
     t->nice = nice;
     t->priority = calaculate_priority(t->recent_cpu, t->nice);
+    t->eff_priority = donated_priority(t);
     intr_set_level(old_level);
 }
 
@@ -593,6 +643,7 @@ static void init_thread(struct thread *t, const char *name, int priority) {
     if (thread_mlfqs) {
         t->priority = calaculate_priority(t->recent_cpu, t->nice);
     }
+    t->eff_priority = t->priority;
 //$ADD/write_handler
 /**
  * @brief fd 0,1 은 표준 입출력을 써야하기에 나중에 NULL이면 리턴하는 식으로 하기 위해 정의
@@ -618,8 +669,7 @@ static void init_thread(struct thread *t, const char *name, int priority) {
 
     t->magic = THREAD_MAGIC;
 
-    list_init(&t->donor_list);                       // 기부자 리스트 초기화
-    list_push_back(&t->donor_list, &t->donor_elem);  // 자신의 donor_elem을 추가하여 빈 리스트 방지
+    list_init(&t->donor_list);  // 기부자 리스트 초기화
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
@@ -778,6 +828,13 @@ static void schedule(void) {
             list_push_back(&destruction_req, &curr->elem);
         }
 
+        /* 아직 실행 가능한 스레드가 밀려난 경우(time slice 만료, 선점)는 비자발적,
+         * block/exit로 CPU를 내려놓은 경우는 자발적 문맥 전환으로 센다. */
+        if (curr->status == THREAD_READY)
+            involuntary_switches++;
+        else
+            voluntary_switches++;
+
         /* Before switching the thread, we first save the information
          * of current running. */
         thread_launch(next);
@@ -873,6 +930,7 @@ void mlfq_run_for_sec(void) {
 void priority_update(void) {
     struct thread *t = thread_current();
     t->priority = calaculate_priority(t->recent_cpu, t->nice);
+    t->eff_priority = donated_priority(t);
     // printf("tid : %lld, priority : %lld, nice : %lld, recent-cpu : %lld\n", t->tid, t->priority,
     // t->nice, t->recent_cpu);
 
@@ -880,6 +938,7 @@ void priority_update(void) {
          e = list_next(e)) {
         t = list_entry(e, struct thread, elem);
         t->priority = calaculate_priority(t->recent_cpu, t->nice);
+        t->eff_priority = donated_priority(t);
         // printf("tid : %lld, priority : %lld, nice : %lld, recent-cpu : %lld\n", t->tid,
         // t->priority, t->nice, t->recent_cpu);
     }
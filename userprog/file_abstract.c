@@ -1,16 +1,36 @@
 #include "userprog/file_abstract.h"
 
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "devices/input.h"
+#include "filesys/directory.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
 #include "userprog/check_perm.h"
 #include "userprog/file_abstract.h"
+#include "user/syscall.h"
 
 struct File STDIN_FILE = {.type = STDIN, .file_ptr = NULL};
 struct File STDOUT_FILE = {.type = STDOUT, .file_ptr = NULL};
 
 struct File* open_file(const char* name) {
-    // 추후 디렉토리 오픈도 구분해서 추가
     struct File* file = calloc(1, sizeof(struct File));
+    if (file == NULL) {
+        return NULL;
+    }
+
+    struct dir* _dir = filesys_open_dir(name);
+    if (_dir != NULL) {
+        file->dir_ptr = _dir;
+        file->type = DIRECTORY;
+        return file;
+    }
+
     struct file* _file = filesys_open(name);
     if (_file == NULL) {
         free(file);
@@ -57,7 +77,8 @@ int read_file(struct File* file, void* buffer, off_t size) {
 off_t write_file(struct File* file, const void* buffer, off_t size) {
     switch (file->type) {
         case STDOUT:
-            return putbuf(buffer, size);
+            putbuf(buffer, size);
+            return size;
 
         case FILE:
             return file_write(file->file_ptr, buffer, size);
@@ -97,6 +118,11 @@ int close_file(struct File* file) {
             free(file);
             return 0;
 
+        case DIRECTORY:
+            dir_close(file->dir_ptr);
+            free(file);
+            return 0;
+
         default:
             return -1;
     }
@@ -116,6 +142,17 @@ struct File* duplicate_file(struct File* file) {
                 return NULL;
             }
             break;
+        case DIRECTORY:
+            new_file = calloc(1, sizeof(struct File));
+            if (new_file == NULL) {
+                return NULL;
+            }
+            new_file->dir_ptr = dir_reopen(file->dir_ptr);
+            if (new_file->dir_ptr == NULL) {
+                free(new_file);
+                return NULL;
+            }
+            break;
         case STDIN:
             new_file = &STDIN_FILE;
             break;
@@ -145,6 +182,114 @@ bool is_file_writable(struct File* file) {
     }
 }
 
+int pread_file(struct File* file, void* buffer, off_t size, off_t offset) {
+    if (offset < 0) {
+        return -1;
+    }
+    switch (file->type) {
+        case FILE:
+            return file_read_at(file->file_ptr, buffer, size, offset);
+
+        default:
+            return -1;
+    }
+}
+
+off_t pwrite_file(struct File* file, const void* buffer, off_t size, off_t offset) {
+    if (offset < 0) {
+        return -1;
+    }
+    switch (file->type) {
+        case FILE:
+            return file_write_at(file->file_ptr, buffer, size, offset);
+
+        default:
+            return -1;
+    }
+}
+
+int readv_file(struct File* file, const struct iovec* iov, int iovcnt) {
+    int total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        int n = read_file(file, iov[i].iov_base, iov[i].iov_len);
+        if (n == -1) {
+            return i == 0 ? -1 : total;
+        }
+        total += n;
+        /* 짧게 읽혔으면 파일 끝이므로 다음 버퍼로 넘어가지 않습니다. */
+        if ((size_t)n < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+int writev_file(struct File* file, const struct iovec* iov, int iovcnt) {
+    int total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        off_t n = write_file(file, iov[i].iov_base, iov[i].iov_len);
+        if (n == -1) {
+            return i == 0 ? -1 : total;
+        }
+        total += n;
+        /* 디스크가 가득 찼거나 쓰기가 금지된 경우 */
+        if ((size_t)n < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+int copy_file(struct File* in, struct File* out, off_t size) {
+    if (in->type != FILE || (out->type != FILE && out->type != STDOUT) || size < 0) {
+        return -1;
+    }
+    /* 사용자 메모리를 거치지 않도록 커널 페이지 하나를 중간 버퍼로 씁니다. */
+    uint8_t* buffer = palloc_get_page(0);
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    int total = 0;
+    while (size > 0) {
+        off_t chunk = size < PGSIZE ? size : PGSIZE;
+        off_t n = file_read(in->file_ptr, buffer, chunk);
+        if (n == 0) {
+            break;
+        }
+        off_t written;
+        if (out->type == STDOUT) {
+            putbuf((const char*)buffer, n);
+            written = n;
+        } else {
+            written = file_write(out->file_ptr, buffer, n);
+        }
+        total += written;
+        /* 디스크가 가득 찼거나 쓰기가 금지된 경우 */
+        if (written < n) {
+            break;
+        }
+        size -= n;
+    }
+    palloc_free_page(buffer);
+    return total;
+}
+
+int sync_file(struct File* file) {
+    switch (file->type) {
+        case FILE:
+            filesys_fsync(file_get_inode(file->file_ptr));
+            return 0;
+
+        case DIRECTORY:
+            filesys_fsync(dir_get_inode(file->dir_ptr));
+            return 0;
+
+        default:
+            return -1;
+    }
+}
+
 bool is_same_file(struct File* a, struct File* b) {
     if (a->type != b->type) {
         return false;
@@ -153,7 +298,59 @@ bool is_same_file(struct File* a, struct File* b) {
         case FILE:
             return (a->file_ptr->inode == b->file_ptr->inode);
 
+        case DIRECTORY:
+            return dir_get_inode(a->dir_ptr) == dir_get_inode(b->dir_ptr);
+
         default:
             return true;
     }
-}
\ No newline at end of file
+}
+
+bool readdir_file(struct File* file, char* name) {
+    if (file->type != DIRECTORY) {
+        return false;
+    }
+    return dir_readdir(file->dir_ptr, name);
+}
+
+/* getdents_file()이 레코드를 채워 나가는 버퍼 상태 */
+struct dirent_buf {
+    char* pos;     /* 다음 레코드를 쓸 위치 */
+    unsigned left; /* 남은 바이트 수 */
+    bool full;     /* 공간이 부족해 멈췄는지 여부 */
+};
+
+/* 엔트리 하나를 dirent 레코드로 기록합니다. 공간이 부족하면 false. */
+static bool emit_dirent(disk_sector_t inode_sector, const char* name, bool is_dir, void* aux) {
+    struct dirent_buf* db = aux;
+    size_t name_len = strlen(name) + 1;
+    unsigned reclen = ROUND_UP(sizeof(struct dirent) + name_len, sizeof(int));
+
+    if (reclen > db->left) {
+        db->full = true;
+        return false;
+    }
+    /* 종류는 디렉터리 엔트리에 함께 기록되어 있어 inode를 열지 않습니다. */
+    struct dirent* d = (struct dirent*)db->pos;
+    d->d_ino = inode_sector;
+    d->d_reclen = reclen;
+    d->d_type = is_dir ? DT_DIR : DT_REG;
+    memcpy(d->d_name, name, name_len);
+    db->pos += reclen;
+    db->left -= reclen;
+    return true;
+}
+
+int getdents_file(struct File* file, void* buffer, unsigned size) {
+    if (file->type != DIRECTORY) {
+        return -1;
+    }
+    struct dirent_buf db = {.pos = buffer, .left = size, .full = false};
+    int cnt = dir_readdir_each(file->dir_ptr, emit_dirent, &db);
+
+    /* 남은 엔트리가 있는데 첫 레코드조차 들어가지 않은 경우 */
+    if (cnt == 0 && db.full) {
+        return -1;
+    }
+    return size - db.left;
+}
@@ -1,5 +1,6 @@
 #include "userprog/syscall.h"
 
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 #include <syscall-nr.h>
@@ -28,6 +29,7 @@ static int exec_handler(const char *file);
 static int wait_handler(pid_t pid);
 static bool create_handler(const char *file, unsigned initial_size);
 static bool remove_handler(const char *file);
+static bool mkdir_handler(const char *dir);
 static int open_handler(const char *file_name);
 static int filesize_handler(int fd);
 static int read_handler(int fd, void *buffer, unsigned size);
@@ -35,6 +37,16 @@ static int write_handler(int fd, const void *buffer, unsigned size);
 static void seek_handler(int fd, unsigned position);
 static unsigned tell_handler(int fd);
 static void close_handler(int fd);
+static bool readdir_handler(int fd, char *name);
+static int getdents_handler(int fd, void *buffer, unsigned size);
+static int fsync_handler(int fd);
+static void sync_handler(void);
+static int pread_handler(int fd, void *buffer, unsigned size, off_t offset);
+static int pwrite_handler(int fd, const void *buffer, unsigned size, off_t offset);
+static int readv_handler(int fd, const struct iovec *iov, int iovcnt);
+static int writev_handler(int fd, const struct iovec *iov, int iovcnt);
+static int copy_file_range_handler(int fd_in, int fd_out, unsigned length);
+static int sendfile_handler(int out_fd, int in_fd, unsigned length);
 /* feat/syscall_handler */
 
 /* System call.
@@ -108,6 +120,39 @@ void syscall_handler(struct intr_frame *f) {
         case SYS_CLOSE:  // syscall_num 13
             close_handler(f->R.rdi);
             break;
+        case SYS_MKDIR:  // syscall_num 17
+            f->R.rax = mkdir_handler((const char *)f->R.rdi);
+            break;
+        case SYS_READDIR:  // syscall_num 18
+            f->R.rax = readdir_handler(f->R.rdi, (char *)f->R.rsi);
+            break;
+        case SYS_GETDENTS:  // syscall_num 25
+            f->R.rax = getdents_handler(f->R.rdi, (void *)f->R.rsi, f->R.rdx);
+            break;
+        case SYS_FSYNC:  // syscall_num 26
+            f->R.rax = fsync_handler(f->R.rdi);
+            break;
+        case SYS_SYNC:  // syscall_num 27
+            sync_handler();
+            break;
+        case SYS_PREAD:  // syscall_num 28
+            f->R.rax = pread_handler(f->R.rdi, (void *)f->R.rsi, f->R.rdx, f->R.r10);
+            break;
+        case SYS_PWRITE:  // syscall_num 29
+            f->R.rax = pwrite_handler(f->R.rdi, (const void *)f->R.rsi, f->R.rdx, f->R.r10);
+            break;
+        case SYS_READV:  // syscall_num 30
+            f->R.rax = readv_handler(f->R.rdi, (const struct iovec *)f->R.rsi, f->R.rdx);
+            break;
+        case SYS_WRITEV:  // syscall_num 31
+            f->R.rax = writev_handler(f->R.rdi, (const struct iovec *)f->R.rsi, f->R.rdx);
+            break;
+        case SYS_COPY_FILE_RANGE:  // syscall_num 32
+            f->R.rax = copy_file_range_handler(f->R.rdi, f->R.rsi, f->R.rdx);
+            break;
+        case SYS_SENDFILE:  // syscall_num 33
+            f->R.rax = sendfile_handler(f->R.rdi, f->R.rsi, f->R.rdx);
+            break;
 
         default:
             printf("system call!\n");
@@ -201,6 +246,16 @@ static bool remove_handler(const char *file) {
     return false;
 }
 
+/* 루트 디렉터리 아래에 빈 디렉터리 생성 */
+static bool mkdir_handler(const char *dir) {
+    if (is_user_accesable(dir, 0, P_USER | IS_STR)) {
+        return filesys_mkdir(dir);
+    }
+    exit_handler(-1);
+    NOT_REACHED();
+    return false;
+}
+
 /* 파일 열기 */
 static int open_handler(const char *file_name) {
     if (file_name && is_user_accesable(file_name, 0, P_USER | IS_STR)) {
@@ -299,3 +354,165 @@ static void close_handler(int fd) {
         NOT_REACHED();
     }
 }
+
+/* 디렉토리 엔트리 이름 하나 읽기 */
+static bool readdir_handler(int fd, char *name) {
+    struct File *get_file = get_file_from_fd(fd);
+    if (get_file == NULL || !is_user_accesable(name, READDIR_MAX_LEN + 1, P_USER | P_WRITE)) {
+        exit_handler(-1);
+    }
+    return readdir_file(get_file, name);
+}
+
+/**
+ * @brief 디렉토리 엔트리를 버퍼에 들어가는 만큼 한 번에 읽습니다.
+ *
+ * @param fd 디렉토리 파일 디스크립터
+ * @param buffer struct dirent 레코드를 채울 사용자 버퍼
+ * @param size 버퍼 크기(바이트)
+ * @return 채운 바이트 수, 끝이면 0, 디렉토리가 아니거나 버퍼가 너무 작으면 -1
+ */
+static int getdents_handler(int fd, void *buffer, unsigned size) {
+    struct File *get_file = get_file_from_fd(fd);
+    if (get_file == NULL || !is_user_accesable(buffer, size, P_USER | P_WRITE)) {
+        exit_handler(-1);
+    }
+    return getdents_file(get_file, buffer, size);
+}
+
+/**
+ * @brief 파일에 쓴 내용을 디스크까지 내려보냅니다.
+ *
+ * write()는 버퍼 캐시에만 쓰므로, 내구성이 필요한 시점에만 호출해 비용을 치릅니다.
+ *
+ * @param fd 파일 디스크립터
+ * @return 성공 시 0, 열려 있지 않은 fd이거나 STDIN/STDOUT이면 -1
+ */
+static int fsync_handler(int fd) {
+    struct File *get_file = get_file_from_fd(fd);
+    if (get_file == NULL) {
+        return -1;
+    }
+    return sync_file(get_file);
+}
+
+/* 캐시된 모든 쓰기를 디스크에 반영 */
+static void sync_handler(void) {
+    filesys_sync();
+}
+
+/* 지정한 오프셋에서 읽기 (파일 커서는 그대로) */
+static int pread_handler(int fd, void *buffer, unsigned size, off_t offset) {
+    struct File *get_file = get_file_from_fd(fd);
+    int result = -1;
+    if (get_file != NULL && is_user_accesable(buffer, size, P_USER | P_WRITE)) {
+        result = pread_file(get_file, buffer, size, offset);
+    }
+    if (result == -1) {
+        exit_handler(-1);
+    }
+    return result;
+}
+
+/* 지정한 오프셋에 쓰기 (파일 커서는 그대로) */
+static int pwrite_handler(int fd, const void *buffer, unsigned size, off_t offset) {
+    struct File *get_file = get_file_from_fd(fd);
+    int result = -1;
+    if (get_file != NULL && is_user_accesable((void *)buffer, size, P_USER)) {
+        result = pwrite_file(get_file, buffer, size, offset);
+    }
+    if (result == -1) {
+        exit_handler(-1);
+    }
+    return result;
+}
+
+/**
+ * @brief iovec 배열과 그 안의 모든 버퍼가 접근 가능한지 한 번에 검사합니다.
+ *
+ * @param iov 사용자 iovec 배열
+ * @param iovcnt 배열 길이 (0 이상 IOV_MAX 이하)
+ * @param flag 각 버퍼에 요구하는 권한
+ * @return 모두 접근 가능하고 길이의 합이 int에 들어가면 true
+ */
+static bool is_iovec_accesable(const struct iovec *iov, int iovcnt,
+                               enum pointer_check_flags flag) {
+    size_t total = 0;
+    if (iovcnt < 0 || iovcnt > IOV_MAX) {
+        return false;
+    }
+    if (iovcnt == 0) {
+        return true;
+    }
+    if (!is_user_accesable((void *)iov, iovcnt * sizeof *iov, P_USER)) {
+        return false;
+    }
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        total += iov[i].iov_len;
+        if (total > INT_MAX || !is_user_accesable(iov[i].iov_base, iov[i].iov_len, flag)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* 여러 버퍼로 읽기: 검사와 fd 조회를 한 번만 합니다. */
+static int readv_handler(int fd, const struct iovec *iov, int iovcnt) {
+    struct File *get_file = get_file_from_fd(fd);
+    int result = -1;
+    if (get_file != NULL && is_iovec_accesable(iov, iovcnt, P_USER | P_WRITE)) {
+        result = readv_file(get_file, iov, iovcnt);
+    }
+    if (result == -1) {
+        exit_handler(-1);
+    }
+    return result;
+}
+
+/* 여러 버퍼에서 쓰기: 검사와 fd 조회를 한 번만 합니다. */
+static int writev_handler(int fd, const struct iovec *iov, int iovcnt) {
+    struct File *get_file = get_file_from_fd(fd);
+    int result = -1;
+    if (get_file != NULL && is_iovec_accesable(iov, iovcnt, P_USER)) {
+        result = writev_file(get_file, iov, iovcnt);
+    }
+    if (result == -1) {
+        exit_handler(-1);
+    }
+    return result;
+}
+
+/**
+ * @brief 파일 사이의 복사를 커널 안에서 처리합니다.
+ *
+ * read/write 쌍과 달리 데이터가 사용자 버퍼로 오가지 않습니다.
+ *
+ * @param fd_in 읽을 파일 디스크립터
+ * @param fd_out 쓸 파일 디스크립터 (일반 파일)
+ * @param length 복사할 최대 바이트 수
+ * @return 복사한 바이트 수, 일반 파일 사이가 아니면 -1
+ */
+static int copy_file_range_handler(int fd_in, int fd_out, unsigned length) {
+    struct File *in = get_file_from_fd(fd_in);
+    struct File *out = get_file_from_fd(fd_out);
+    if (in == NULL || out == NULL) {
+        exit_handler(-1);
+    }
+    if (out->type != FILE) {
+        return -1;
+    }
+    return copy_file(in, out, length > INT_MAX ? INT_MAX : length);
+}
+
+/* 파일 내용을 다른 파일이나 STDOUT으로 커널 안에서 복사 */
+static int sendfile_handler(int out_fd, int in_fd, unsigned length) {
+    struct File *in = get_file_from_fd(in_fd);
+    struct File *out = get_file_from_fd(out_fd);
+    if (in == NULL || out == NULL) {
+        exit_handler(-1);
+    }
+    return copy_file(in, out, length > INT_MAX ? INT_MAX : length);
+}